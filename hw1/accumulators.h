@@ -0,0 +1,365 @@
+#ifndef HW1_ACCUMULATORS_H
+#define HW1_ACCUMULATORS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+// Шаблонные версии сумм, длины, многочлена и статистики: тип элементов T и политика
+// накопления выбираются при компиляции, так что внутри циклов нет ветвлений по режиму.
+//
+// Политика задаёт Accumulator<T> с операциями
+//   add(x)           s += x
+//   addProduct(a, b) s += a * b
+//   mulAdd(x, a)     s = s * x + a  (шаг схемы Горнера)
+//   merge(other)     s += other
+//   value()          результат, округлённый к T
+
+template<class T>
+struct Wider {
+    using type = double;
+};
+
+template<>
+struct Wider<double> {
+    using type = long double;
+};
+
+// Knuth's TwoSum: a + b = s + err exactly, without branches.
+template<class T>
+inline void twoSum(T a, T b, T& s, T& err) {
+    s = a + b;
+    T bp = s - a;
+    err = (a - (s - bp)) + (b - bp);
+}
+
+// a * b = p + err exactly.
+template<class T>
+inline void twoProd(T a, T b, T& p, T& err) {
+    p = a * b;
+    err = std::fma(a, b, -p);
+}
+
+// обычное накопление в T
+struct NaiveSum {
+    template<class T>
+    struct Accumulator {
+        T s = 0;
+
+        void add(T x) {
+            s += x;
+        }
+
+        void addProduct(T a, T b) {
+            s = std::fma(a, b, s);
+        }
+
+        void mulAdd(T x, T a) {
+            s = std::fma(s, x, a);
+        }
+
+        void merge(const Accumulator& other) {
+            s += other.s;
+        }
+
+        T value() const {
+            return s;
+        }
+    };
+};
+
+// компенсированное накопление (вариант Ноймайера через TwoSum); для многочлена -- CompHorner
+struct KahanSum {
+    template<class T>
+    struct Accumulator {
+        T s = 0;
+        T c = 0;
+
+        void add(T x) {
+            T err;
+            twoSum(s, x, s, err);
+            c += err;
+        }
+
+        void addProduct(T a, T b) {
+            T p, pe;
+            twoProd(a, b, p, pe);
+            add(p);
+            c += pe;
+        }
+
+        void mulAdd(T x, T a) {
+            T p, pe, se;
+            twoProd(s, x, p, pe);
+            twoSum(p, a, s, se);
+            c = std::fma(c, x, pe + se);
+        }
+
+        void merge(const Accumulator& other) {
+            add(other.s);
+            c += other.c;
+        }
+
+        T value() const {
+            return s + c;
+        }
+    };
+};
+
+// накопление в более широком типе: float -> double, double -> long double
+struct WideSum {
+    template<class T>
+    struct Accumulator {
+        using W = typename Wider<T>::type;
+        W s = 0;
+
+        void add(T x) {
+            s += x;
+        }
+
+        void addProduct(T a, T b) {
+            s = std::fma(W(a), W(b), s);
+        }
+
+        void mulAdd(T x, T a) {
+            s = std::fma(s, W(x), W(a));
+        }
+
+        void merge(const Accumulator& other) {
+            s += other.s;
+        }
+
+        T value() const {
+            return (T) s;
+        }
+    };
+};
+
+// накопление в double-double (около 106 бит мантиссы)
+struct DoubleDoubleSum {
+    template<class T>
+    struct Accumulator {
+        double hi = 0;
+        double lo = 0;
+
+        void add(T x) {
+            double s, err;
+            twoSum(hi, (double) x, s, err);
+            normalize(s, lo + err);
+        }
+
+        void addProduct(T a, T b) {
+            double p, pe;
+            twoProd((double) a, (double) b, p, pe);
+            double s, err;
+            twoSum(hi, p, s, err);
+            normalize(s, lo + err + pe);
+        }
+
+        void mulAdd(T x, T a) {
+            double p, pe;
+            twoProd(hi, (double) x, p, pe);
+            pe = std::fma(lo, (double) x, pe);
+            double s, err;
+            twoSum(p, (double) a, s, err);
+            normalize(s, pe + err);
+        }
+
+        void merge(const Accumulator& other) {
+            double s, err;
+            twoSum(hi, other.hi, s, err);
+            normalize(s, lo + other.lo + err);
+        }
+
+        T value() const {
+            return (T) (hi + lo);
+        }
+
+    private:
+        void normalize(double s, double e) {
+            hi = s + e;
+            lo = e - (hi - s);
+        }
+    };
+};
+
+const size_t ACCUMULATOR_LANES = 8;
+
+// Independent lanes give the compiler room to vectorize and shorten the dependency chain.
+template<class Policy, class T>
+T sum(const T* x, size_t n) {
+    typename Policy::template Accumulator<T> lanes[ACCUMULATOR_LANES];
+    size_t i = 0;
+    for (; i + ACCUMULATOR_LANES <= n; i += ACCUMULATOR_LANES) {
+        for (size_t k = 0; k < ACCUMULATOR_LANES; k++) {
+            lanes[k].add(x[i + k]);
+        }
+    }
+    for (; i < n; i++) {
+        lanes[0].add(x[i]);
+    }
+    for (size_t k = 1; k < ACCUMULATOR_LANES; k++) {
+        lanes[0].merge(lanes[k]);
+    }
+    return lanes[0].value();
+}
+
+// Готовые векторные ядра для float, см. tasks.cpp.
+template<>
+float sum<NaiveSum, float>(const float* x, size_t n);
+
+template<>
+float sum<KahanSum, float>(const float* x, size_t n);
+
+template<>
+float sum<WideSum, float>(const float* x, size_t n);
+
+// Blue's thresholds and scales for T, as in LAPACK's la_constants.
+template<class T>
+struct BlueConstants {
+    T tsml, tbig, ssml, sbig;
+
+    BlueConstants() {
+        using L = std::numeric_limits<T>;
+        tsml = std::ldexp(T(1), (int) std::ceil((L::min_exponent - 1) * 0.5));
+        tbig = std::ldexp(T(1), (int) std::floor((L::max_exponent - L::digits + 1) * 0.5));
+        ssml = std::ldexp(T(1), -(int) std::floor((L::min_exponent - L::digits) * 0.5));
+        sbig = std::ldexp(T(1), -(int) std::ceil((L::max_exponent + L::digits - 1) * 0.5));
+    }
+};
+
+template<class Policy, class T>
+T length(const T* x, size_t n) {
+    static const BlueConstants<T> k;
+    typename Policy::template Accumulator<T> sml, med, big;
+    for (size_t i = 0; i < n; i++) {
+        T ax = std::fabs(x[i]);
+        bool isBig = ax > k.tbig;
+        bool isSml = ax < k.tsml;
+        T scaled = ax * (isBig ? k.sbig : isSml ? k.ssml : T(1));
+        big.addProduct(isBig ? scaled : T(0), scaled);
+        sml.addProduct(isSml ? scaled : T(0), scaled);
+        med.addProduct(isBig || isSml ? T(0) : scaled, scaled);
+    }
+    T abig = big.value(), amed = med.value(), asml = sml.value();
+    if (abig > 0) {
+        if (amed > 0 || std::isnan(amed)) {
+            abig += (amed * k.sbig) * k.sbig;
+        }
+        return std::sqrt(abig) / k.sbig;
+    }
+    if (asml > 0) {
+        if (amed > 0 || std::isnan(amed)) {
+            T ymed = std::sqrt(amed);
+            T ysml = std::sqrt(asml) / k.ssml;
+            T ymin = std::min(ymed, ysml);
+            T ymax = std::max(ymed, ysml);
+            return ymax * std::sqrt(1 + (ymin / ymax) * (ymin / ymax));
+        }
+        return std::sqrt(asml) / k.ssml;
+    }
+    return std::sqrt(amed);
+}
+
+template<class Policy, class T>
+T polynomial(T x, const T* a, size_t n) {
+    if (n == 0) {
+        return 0;
+    }
+    typename Policy::template Accumulator<T> acc;
+    acc.add(a[n - 1]);
+    for (size_t i = n - 1; i-- > 0;) {
+        acc.mulAdd(x, a[i]);
+    }
+    return acc.value();
+}
+
+// Статистика на сдвинутых данных: копятся суммы (x - K) и (x - K)^2, где K -- первый элемент.
+// Деления на каждом шаге нет, а точность сумм определяет политика.
+template<class T, class Policy = WideSum>
+class BasicStatistics {
+private:
+    using Accumulator = typename Policy::template Accumulator<T>;
+
+    size_t savedCount = 0;
+    T shift = 0;
+    T savedMin = 0;
+    T savedMax = 0;
+    Accumulator total;
+    Accumulator shifted;
+    Accumulator squares;
+
+public:
+    void update(T x) {
+        if (savedCount == 0) {
+            shift = x;
+            savedMin = x;
+            savedMax = x;
+        }
+        savedMin = std::min(savedMin, x);
+        savedMax = std::max(savedMax, x);
+        savedCount++;
+        total.add(x);
+        T d = x - shift;
+        shifted.add(d);
+        squares.addProduct(d, d);
+    }
+
+    void update(const T* x, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            update(x[i]);
+        }
+    }
+
+    // Moves the other shifted sums to our shift K: with delta = K' - K,
+    // sum(x - K) = sum(x - K') + n' * delta, sum(x - K)^2 = sum(x - K')^2 + 2 * delta * sum(x - K') + n' * delta^2.
+    void merge(const BasicStatistics& other) {
+        if (other.savedCount == 0) {
+            return;
+        }
+        if (savedCount == 0) {
+            *this = other;
+            return;
+        }
+        T delta = other.shift - shift;
+        T otherCount = (T) other.savedCount;
+        squares.merge(other.squares);
+        squares.addProduct(2 * delta, other.shifted.value());
+        squares.addProduct(otherCount * delta, delta);
+        shifted.merge(other.shifted);
+        shifted.addProduct(otherCount, delta);
+        total.merge(other.total);
+        savedCount += other.savedCount;
+        savedMin = std::min(savedMin, other.savedMin);
+        savedMax = std::max(savedMax, other.savedMax);
+    }
+
+    size_t count() const noexcept {
+        return savedCount;
+    }
+
+    T min() const noexcept {
+        return savedMin;
+    }
+
+    T max() const noexcept {
+        return savedMax;
+    }
+
+    T sum() const noexcept {
+        return total.value();
+    }
+
+    T mean() const noexcept {
+        return shift + shifted.value() / (T) savedCount;
+    }
+
+    T variance() const noexcept {
+        T s = shifted.value();
+        T n = (T) savedCount;
+        return std::max(T(0), (squares.value() - s * (s / n)) / n);
+    }
+};
+
+#endif //HW1_ACCUMULATORS_H
@@ -0,0 +1,168 @@
+// Замеры скорости и точности сумм и норм. Вывод -- JSON, по записи на ядро/распределение/размер.
+//   hw1_bench [maxElements]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "functions.h"
+#include "simd.h"
+#include "parallel.h"
+#include "accumulators.h"
+
+namespace {
+
+    struct Dataset {
+        std::string name;
+        std::vector<float> values;
+        double exactSum;
+        double exactLength;
+    };
+
+    std::vector<float> generate(const std::string& distribution, size_t n) {
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> unit(0.f, 1.f);
+        std::vector<float> x(n);
+        if (distribution == "well-conditioned") {
+            for (auto& v: x) {
+                v = 1.f + unit(gen);
+            }
+        } else if (distribution == "alternating-sign") {
+            for (size_t i = 0; i < n; i++) {
+                x[i] = (i % 2 == 0 ? 1.f : -1.f) * (1.f + unit(gen));
+            }
+        } else {
+            // Ill-conditioned: magnitudes spread over 2^40 cancel almost exactly, the true sum is tiny.
+            std::uniform_int_distribution<int> exponent(-20, 20);
+            size_t half = n / 2;
+            for (size_t i = 0; i < half; i++) {
+                x[i] = std::ldexp(1.f + unit(gen), exponent(gen)) * (i % 2 == 0 ? 1.f : -1.f);
+                x[half + i] = -x[i];
+            }
+            for (size_t i = 0; i < n; i += 97) {
+                x[i] += unit(gen) * 1e-3f;
+            }
+            std::shuffle(x.begin(), x.end(), gen);
+        }
+        return x;
+    }
+
+    // Reference: every float and every float square is exact in double, double-double keeps the rest.
+    Dataset makeDataset(const std::string& distribution, size_t n) {
+        Dataset data = {distribution, generate(distribution, n), 0, 0};
+        DoubleDoubleSum::Accumulator<double> total, squares;
+        for (float v: data.values) {
+            total.add(v);
+            squares.add((double) v * v);
+        }
+        data.exactSum = total.hi + total.lo;
+        data.exactLength = (double) std::sqrt((long double) squares.hi + squares.lo);
+        return data;
+    }
+
+    double ulpError(float got, double exact) {
+        float rounded = (float) exact;
+        float ulp = std::nextafter(std::fabs(rounded), std::numeric_limits<float>::infinity()) - std::fabs(rounded);
+        if (!(ulp > 0)) {
+            ulp = std::numeric_limits<float>::denorm_min();
+        }
+        return std::fabs((double) got - exact) / ulp;
+    }
+
+    struct Kernel {
+        std::string name;
+        bool norm;
+        std::function<float(const float*, size_t)> run;
+    };
+
+    std::vector<Kernel> kernels(ParallelReducer& reducer) {
+        std::vector<Kernel> result;
+        const SumKernels* isas[4];
+        size_t count = supportedKernels(isas, 4);
+        for (size_t i = 0; i < count; i++) {
+            const SumKernels* k = isas[i];
+            std::string isa = k->name;
+            result.push_back({"dummy/" + isa, false, k->dummy});
+            result.push_back({"kahan/" + isa, false, k->kahan});
+            result.push_back({"wide/" + isa, false, [k](const float* x, size_t n) { return (float) k->wide(x, n); }});
+            result.push_back({"pairwise/" + isa, false,
+                              [k](const float* x, size_t n) { return pairwiseSum(*k, x, n); }});
+            result.push_back({"length/" + isa, true, [k](const float* x, size_t n) {
+                float out;
+                k->norms(x, 1, n, &out);
+                return out;
+            }});
+        }
+        result.push_back({"sum<DoubleDoubleSum>", false, sum<DoubleDoubleSum, float>});
+        result.push_back({"length<WideSum>", true, length<WideSum, float>});
+        result.push_back({"length<DoubleDoubleSum>", true, length<DoubleDoubleSum, float>});
+        result.push_back({"exact", false, exact_sum});
+        result.push_back({"summarize.kahan", false,
+                          [](const float* x, size_t n) { return summarize(x, n).kahan; }});
+        result.push_back({"summarize.length", true,
+                          [](const float* x, size_t n) { return summarize(x, n).length; }});
+        std::string threads = std::to_string(reducer.threads());
+        ParallelReducer* r = &reducer;
+        result.push_back({"parallel-dummy/" + threads, false,
+                          [r](const float* x, size_t n) { return r->dummy_sum(x, n); }});
+        result.push_back({"parallel-kahan/" + threads, false,
+                          [r](const float* x, size_t n) { return r->kahan_sum(x, n); }});
+        result.push_back({"parallel-pairwise/" + threads, false,
+                          [r](const float* x, size_t n) { return r->pairwise_sum(x, n); }});
+        result.push_back({"parallel-exact/" + threads, false,
+                          [r](const float* x, size_t n) { return r->exact_sum(x, n); }});
+        result.push_back({"parallel-length/" + threads, true,
+                          [r](const float* x, size_t n) { return r->length(x, n); }});
+        return result;
+    }
+
+    // Best of several runs, at least 3 and at least ~20 ms of work in total.
+    double secondsPerRun(const Kernel& kernel, const std::vector<float>& x, float& result) {
+        using clock = std::chrono::steady_clock;
+        double best = std::numeric_limits<double>::infinity();
+        double spent = 0;
+        for (int run = 0; run < 3 || (spent < 0.02 && run < 10000); run++) {
+            auto start = clock::now();
+            result = kernel.run(x.data(), x.size());
+            double seconds = std::chrono::duration<double>(clock::now() - start).count();
+            best = std::min(best, seconds);
+            spent += seconds;
+        }
+        return best;
+    }
+
+}
+
+int main(int argc, char** argv) {
+    size_t maxElements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : size_t(1) << 26;
+    ParallelReducer reducer;
+    auto all = kernels(reducer);
+
+    std::printf("{\n  \"active_isa\": \"%s\",\n  \"threads\": %u,\n  \"results\": [", activeKernels().name,
+                reducer.threads());
+    bool first = true;
+    // 4 KB fits in L1, the largest sizes only in DRAM.
+    for (size_t n = 1024; n <= maxElements; n *= 16) {
+        for (const char* distribution: {"well-conditioned", "ill-conditioned", "alternating-sign"}) {
+            Dataset data = makeDataset(distribution, n);
+            for (const auto& kernel: all) {
+                float result = 0;
+                double seconds = secondsPerRun(kernel, data.values, result);
+                double exact = kernel.norm ? data.exactLength : data.exactSum;
+                std::printf("%s\n    {\"kernel\": \"%s\", \"distribution\": \"%s\", \"n\": %zu, "
+                            "\"ns_per_element\": %.4f, \"gb_per_s\": %.3f, \"result\": %.9g, \"exact\": %.17g, "
+                            "\"ulp_error\": %.4g}",
+                            first ? "" : ",", kernel.name.c_str(), distribution, n, seconds * 1e9 / (double) n,
+                            (double) n * sizeof(float) / seconds / 1e9, result, exact, ulpError(result, exact));
+                first = false;
+            }
+        }
+    }
+    std::printf("\n  ]\n}\n");
+}
@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include "functions.h"
+#include "simd.h"
+
+// Every finite float is m * 2^(max(e, 1) - 150) with a 24-bit integer m and the 8-bit exponent field e,
+// so the exact sum is 2^-149 * sum_e bins[e] * 2^(max(e, 1) - 1), where bins[e] adds up signed mantissas.
+// A bin gains less than 2^24 per element and holds 2^63, so bins are flushed into the 384-bit integer
+// long before overflow. The largest term is below 2^(63 + 253), which leaves plenty of headroom.
+//
+// Most data never needs the per-element scatter. Within a block of 2^12 elements whose exponent fields lie
+// in a band of 18 values starting at b, every element is a multiple of 2^(max(b, 1) - 150) below 2^41 such
+// units, so any partial sum is below 2^53 units and exact in double, whatever the order. The pass that finds
+// a block's exponent range also sums it, which is the answer when the block fits one band; wider blocks are
+// summed band by band. Each band lands in its bin as one integer. Only blocks with infinities or NaNs go
+// through the scatter.
+
+namespace {
+
+    // Counted in elements of the scatter: each adds less than 2^24 to a bin.
+    const uint64_t FLUSH_EVERY = uint64_t(1) << 36;
+    const size_t BLOCK = 4096;
+    // Exponent fields per band: 24 mantissa bits + 17 + log2(BLOCK) = 53.
+    const int BAND = 18;
+
+    inline int binShift(int e) {
+        return e == 0 ? 0 : e - 1;
+    }
+
+    // limbs += other, both in two's complement.
+    template<int N>
+    void addLimbs(uint64_t* limbs, const uint64_t* other) {
+        unsigned carry = 0;
+        for (int i = 0; i < N; i++) {
+            uint64_t sum = limbs[i] + other[i];
+            unsigned c1 = sum < other[i];
+            uint64_t total = sum + carry;
+            carry = c1 | (total < sum);
+            limbs[i] = total;
+        }
+    }
+
+}
+
+void ExactAccumulator::addShifted(uint64_t* limbs, int64_t v, int shift) {
+    if (v == 0) {
+        return;
+    }
+    uint64_t fill = v < 0 ? ~uint64_t(0) : 0;
+    uint64_t term[LIMBS];
+    for (int i = 0; i < LIMBS; i++) {
+        term[i] = fill;
+    }
+    int index = shift / 64;
+    int offset = shift % 64;
+    term[index] = (uint64_t) v << offset;
+    if (index + 1 < LIMBS && offset != 0) {
+        term[index + 1] = (uint64_t) (v >> (64 - offset));
+    }
+    for (int i = 0; i < index; i++) {
+        term[i] = 0;
+    }
+    addLimbs<LIMBS>(limbs, term);
+}
+
+void ExactAccumulator::flush() {
+    for (int k = 0; k < TABLES; k++) {
+        for (int e = 0; e < 255; e++) {
+            addShifted(limbs, bins[k][e], binShift(e));
+            bins[k][e] = 0;
+        }
+    }
+    pending = 0;
+}
+
+void ExactAccumulator::scatter(const float* x, size_t n) {
+    size_t i = 0;
+    while (i < n) {
+        size_t end = i + (size_t) std::min<uint64_t>(n - i, FLUSH_EVERY - pending);
+        pending += end - i;
+        // Neighbouring elements go to different copies of the bins, so runs of equal exponents
+        // do not serialize on a single memory location.
+        for (; i < end; i++) {
+            uint32_t bits;
+            std::memcpy(&bits, x + i, sizeof(bits));
+            uint32_t e = (bits >> 23) & 0xff;
+            int64_t m = (bits & 0x7fffff) | (e != 0 ? 0x800000 : 0);
+            if (e == 255) {
+                nan = nan || m != 0x800000;
+                posInf = posInf || (m == 0x800000 && (bits >> 31) == 0);
+                negInf = negInf || (m == 0x800000 && (bits >> 31) != 0);
+                continue;
+            }
+            bins[i % TABLES][e] += (bits >> 31) ? -m : m;
+        }
+        if (pending == FLUSH_EVERY) {
+            flush();
+        }
+    }
+}
+
+void ExactAccumulator::add(const float* x, size_t n) {
+    const SumKernels& kernels = activeKernels();
+    for (size_t begin = 0; begin < n; begin += BLOCK) {
+        size_t len = std::min(BLOCK, n - begin);
+        const float* block = x + begin;
+        MagnitudeRange range = kernels.magnitudes(block, len);
+        if (range.highest == 0) {
+            continue;
+        }
+        int top = (int) (range.highest >> 23);
+        if (top == 255) {
+            scatter(block, len);
+            continue;
+        }
+        // A band sum is below 2^53 units, as much as 2^29 elements of the scatter.
+        uint64_t weight = (uint64_t) len << (BAND - 1);
+        if (pending + weight > FLUSH_EVERY) {
+            flush();
+        }
+        pending += weight;
+        int bottom = std::max((int) (range.lowest >> 23), 1);
+        // One band is the common case, and its sum came with the range.
+        if (top < bottom + BAND) {
+            bins[0][bottom] += (int64_t) std::ldexp(range.sum, 150 - bottom);
+            continue;
+        }
+        for (int low = bottom; low <= top; low += BAND) {
+            // The first band also takes the subnormals: they share the grid of exponent field 1.
+            uint32_t from = low == bottom ? 0 : (uint32_t) low << 23;
+            uint32_t to = (uint32_t) std::min(low + BAND, 255) << 23;
+            double sum = kernels.bandSum(block, len, from, to);
+            bins[0][low] += (int64_t) std::ldexp(sum, 150 - low);
+        }
+    }
+}
+
+void ExactAccumulator::merge(const ExactAccumulator& other) {
+    for (int k = 0; k < TABLES; k++) {
+        for (int e = 0; e < 255; e++) {
+            addShifted(limbs, other.bins[k][e], binShift(e));
+        }
+    }
+    addLimbs<LIMBS>(limbs, other.limbs);
+    nan = nan || other.nan;
+    posInf = posInf || other.posInf;
+    negInf = negInf || other.negInf;
+}
+
+float ExactAccumulator::value() const {
+    if (nan || (posInf && negInf)) {
+        return std::numeric_limits<float>::quiet_NaN();
+    }
+    if (posInf || negInf) {
+        return posInf ? std::numeric_limits<float>::infinity() : -std::numeric_limits<float>::infinity();
+    }
+    uint64_t v[LIMBS];
+    std::memcpy(v, limbs, sizeof(v));
+    for (int k = 0; k < TABLES; k++) {
+        for (int e = 0; e < 255; e++) {
+            addShifted(v, bins[k][e], binShift(e));
+        }
+    }
+    bool negative = (v[LIMBS - 1] >> 63) != 0;
+    if (negative) {
+        unsigned carry = 1;
+        for (int i = 0; i < LIMBS; i++) {
+            v[i] = ~v[i] + carry;
+            carry = carry && v[i] == 0;
+        }
+    }
+    int top = -1;
+    for (int i = LIMBS - 1; i >= 0 && top < 0; i--) {
+        if (v[i] != 0) {
+            top = i * 64 + 63 - __builtin_clzll(v[i]);
+        }
+    }
+    if (top < 0) {
+        return 0.f;
+    }
+    auto bit = [&v](int i) -> uint64_t {
+        return (v[i / 64] >> (i % 64)) & 1;
+    };
+    auto anyBelow = [&v](int i) {
+        for (int w = 0; w < i / 64; w++) {
+            if (v[w] != 0) {
+                return true;
+            }
+        }
+        return (v[i / 64] & ((uint64_t(1) << (i % 64)) - 1)) != 0;
+    };
+    // Keep 24 significant bits, but never cut below 2^-149: subnormal results are exact at that scale.
+    int shift = std::max(top - 23, 0);
+    uint64_t mantissa = 0;
+    for (int i = top; i >= shift; i--) {
+        mantissa = (mantissa << 1) | bit(i);
+    }
+    // Round half to even on the guard bit, the sticky bits below it and the last kept bit.
+    if (shift > 0 && bit(shift - 1) && (anyBelow(shift - 1) || (mantissa & 1))) {
+        mantissa++;
+        if (mantissa == (uint64_t(1) << 24)) {
+            mantissa >>= 1;
+            shift++;
+        }
+    }
+    // ldexp of an integer below 2^24 is exact unless it overflows, and overflow is infinity either way.
+    float result = std::ldexp((float) mantissa, shift - 149);
+    return negative ? -result : result;
+}
+
+float exact_sum(const float* x, size_t n) {
+    ExactAccumulator acc;
+    acc.add(x, n);
+    return acc.value();
+}
@@ -3,27 +3,94 @@
 
 #include <cmath>
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
 
-float polynomial(float x, const float* a, int n);
+float polynomial(float x, const float* a, size_t n);
 
-float kahan_sum(const float* x, int n);
+// значения многочлена a[0..n) во всех точках x[0..count) сразу
+void polynomial(const float* x, size_t count, const float* a, size_t n, float* out);
 
-float dummy_sum(const float* x, int n);
+// схема Эстрина: глубина цепочки зависимостей O(log n) вместо n
+float polynomial_estrin(float x, const float* a, size_t n);
 
-float pairwise_sum_simd(float* x, int n);
+template<size_t K>
+struct HornerStep {
+    static float eval(float x, const float* a) {
+        return std::fma(HornerStep<K - 1>::eval(x, a + 1), x, a[0]);
+    }
+};
+
+template<>
+struct HornerStep<1> {
+    static float eval(float, const float* a) {
+        return a[0];
+    }
+};
+
+// степень известна при компиляции, цикл разворачивается полностью
+template<size_t N>
+float polynomial(float x, const float (&a)[N]) {
+    return HornerStep<N>::eval(x, a);
+}
+
+float kahan_sum(const float* x, size_t n);
+
+float dummy_sum(const float* x, size_t n);
+
+// попарное суммирование, массив не изменяется
+float pairwise_sum_simd(const float* x, size_t n);
+
+// Точная сумма: целое с фиксированной точкой на весь диапазон float, округление одно, в самом конце.
+// Результат не зависит от порядка слагаемых, так что частичные аккумуляторы можно сливать в любом порядке.
+class ExactAccumulator {
+public:
+    void add(const float* x, size_t n);
+
+    void merge(const ExactAccumulator& other);
+
+    float value() const;             // правильно округлённая сумма всего добавленного
+
+private:
+    static const int TABLES = 4;
+    static const int LIMBS = 6;
+
+    int64_t bins[TABLES][256] = {};  // знаковые мантиссы по полю порядка
+    uint64_t limbs[LIMBS] = {};      // сброшенные корзины, 384 бита в дополнительном коде
+    uint64_t pending = 0;
+    bool nan = false;
+    bool posInf = false;
+    bool negInf = false;
+
+    void flush();
+
+    void scatter(const float* x, size_t n);  // поэлементно, с бесконечностями и NaN
+
+    static void addShifted(uint64_t* limbs, int64_t v, int shift);
+};
+
+float exact_sum(const float* x, size_t n);
+
+struct Summary;
 
 class Statistics {
 private:
-    float savedSum = 0;
-    int savedCount = 0;
-    float savedMean = 0;
-    float helperM = 0;
+    double savedSum = 0;
+    size_t savedCount = 0;
+    double savedMean = 0;
+    double helperM = 0;
     float savedMin;
     float savedMax;
 
+    void mergeMoments(size_t n, double sum, double mean, double m2, float lo, float hi);
+
+    friend Summary summarize(const float* x, size_t n);
+
 public:
     void update(float x);            // добавить новый элемент
-    int count() const noexcept;
+    void update(const float* x, size_t n); // добавить сразу n элементов
+    void merge(const Statistics& other);   // объединить с накопленной отдельно статистикой
+    size_t count() const noexcept;
 
     float min() const noexcept;
 
@@ -36,6 +103,19 @@ public:
 };
 
 
-float length(const float* x, int n);
+float length(const float* x, size_t n);
+
+// длины всех строк матрицы rows x cols (по строкам подряд), out -- rows элементов
+void row_lengths(const float* x, size_t rows, size_t cols, float* out);
+
+// Все метрики сразу, за один проход по памяти.
+struct Summary {
+    float dummy;
+    float kahan;
+    float length;
+    Statistics stats;
+};
+
+Summary summarize(const float* x, size_t n);
 
 #endif //HW1_FUNCTIONS_H
@@ -1,9 +1,16 @@
 #include <iostream>
+#include <cmath>
+#include <limits>
 #include <bitset>
 #include <cassert>
 #include "functions.h"
 #include <iomanip>
 #include <vector>
+#include <chrono>
+#include <thread>
+#include "parallel.h"
+#include "mapped_file.h"
+#include "accumulators.h"
 
 void checkSimpleSums();
 
@@ -36,6 +43,21 @@ void printFraction(float f) {
 void checkPolynomial() {
     float a[] = {1.0, 2.0, 3.0};
     assert(polynomial(3.0, a, 3) == 34.0);
+    assert(polynomial(3.f, a) == 34.0);
+    assert(polynomial_estrin(3.f, a, 3) == 34.0);
+
+    float b[] = {1.f, -2.f, 0.5f, 3.f, -1.f, 0.25f, 2.f, -0.75f, 1.5f};
+    std::vector<float> xs, ys(100);
+    for (int i = 0; i < 100; i++) {
+        xs.push_back((float) i / 50.f - 1.f);
+    }
+    polynomial(xs.data(), xs.size(), b, 9, ys.data());
+    for (size_t i = 0; i < xs.size(); i++) {
+        float expected = polynomial(xs[i], b, 9);
+        assert(ys[i] == expected);
+        assert(polynomial(xs[i], b) == expected);
+        assert(std::fabs(polynomial_estrin(xs[i], b, 9) - expected) < 1e-5f);
+    }
 }
 
 void checkKahanSum() {
@@ -79,6 +101,45 @@ void checkPairwiseSum() {
     std::cout << "Pairwise test end" << std::endl << std::endl;
 }
 
+void checkExactSum() {
+    std::cout << "Exact test start" << std::endl;
+    std::vector<float> d = {1e30f, 1.f, -1e30f, 1e-45f, 3.f};
+    assert(exact_sum(d.data(), d.size()) == 4.f);
+    // 2^24 + 1 is exactly between two floats: a tie goes to the even one, a tiny extra term breaks it.
+    d = {16777216.f, 1.f};
+    assert(exact_sum(d.data(), d.size()) == 16777216.f);
+    d.push_back(1e-45f);
+    assert(exact_sum(d.data(), d.size()) == 16777218.f);
+    float tiny = std::numeric_limits<float>::denorm_min();
+    d = {tiny, tiny, -3 * tiny};
+    assert(exact_sum(d.data(), d.size()) == -tiny);
+    d = {3e38f, 3e38f};
+    assert(std::isinf(exact_sum(d.data(), d.size())));
+    d = {INFINITY, -INFINITY};
+    assert(std::isnan(exact_sum(d.data(), d.size())));
+
+    d.assign(3000000, 0.f);
+    double wide = 0;
+    for (size_t i = 0; i < d.size(); i++) {
+        d[i] = std::ldexp((float) (i % 1000) / 7.f - 71.f, (int) (i % 17));
+        wide += d[i];
+    }
+    float exact = exact_sum(d.data(), d.size());
+    // every term is a multiple of 2^-20 below 2^36, so the double sum is exact too
+    assert(exact == (float) wide);
+    ExactAccumulator left, right;
+    left.add(d.data(), d.size() / 3);
+    right.add(d.data() + d.size() / 3, d.size() - d.size() / 3);
+    left.merge(right);
+    assert(left.value() == exact);
+    for (unsigned threads: {1u, 3u, 8u}) {
+        ParallelReducer reducer(threads);
+        assert(reducer.exact_sum(d.data(), d.size()) == exact);
+    }
+    std::cout << "exact " << exact << " kahan " << kahan_sum(d.data(), d.size()) << std::endl;
+    std::cout << "Exact test end" << std::endl;
+}
+
 void checkStats() {
     std::cout << std::endl;
     Statistics statistics;
@@ -91,21 +152,173 @@ void checkStats() {
     assert(statistics.variance() == 8.f);
     assert(statistics.min() == 2.f);
     assert(statistics.max() == 10.f);
+
+    float values[] = {2.f, 4.f, 6.f, 8.f, 10.f};
+    Statistics left, right, batch;
+    left.update(values, 2);
+    right.update(values + 2, 3);
+    left.merge(right);
+    batch.update(values, 5);
+    for (auto* merged: {&left, &batch}) {
+        assert(merged->count() == 5);
+        assert(merged->sum() == 30.f);
+        assert(merged->mean() == 6.f);
+        assert(merged->variance() == 8.f);
+        assert(merged->min() == 2.f);
+        assert(merged->max() == 10.f);
+    }
     std::cout << "STATISTICS TEST CORRECT" << std::endl;
 }
 
 void checkLength() {
     std::vector<float> d = {2.0, 3.0, 6.0};
     assert(std::fabs(length(d.data(), d.size()) - 7.0) < 1e-5);
+
+    std::vector<float> huge = {3e30f, 4e30f, 0.f, 3e-30f, 4e-30f, 0.f, 1.f, 2.f, 2.f};
+    float rows[3];
+    row_lengths(huge.data(), 3, 3, rows);
+    assert(std::fabs(rows[0] / 5e30f - 1.f) < 1e-6f);
+    assert(std::fabs(rows[1] / 5e-30f - 1.f) < 1e-6f);
+    assert(std::fabs(rows[2] - 3.f) < 1e-6f);
 }
 
-int main() {
+void checkSummary() {
+    std::vector<float> d;
+    for (int i = 0; i < 10007; i++) {
+        d.push_back((float) (i % 17) * 0.37f - 3.1f);
+    }
+    Summary summary = summarize(d.data(), d.size());
+    Statistics stats;
+    stats.update(d.data(), d.size());
+    // Both are compensated, but over different lane counts, so they agree to rounding only.
+    float kahan = kahan_sum(d.data(), d.size());
+    assert(std::fabs(summary.kahan - kahan) < 1e-6f * std::fabs(kahan));
+    assert(std::fabs(summary.dummy - summary.kahan) < 1e-3f * std::fabs(summary.kahan));
+    assert(std::fabs(summary.length - length(d.data(), d.size())) < 1e-5f * summary.length);
+    assert(summary.stats.count() == stats.count());
+    assert(summary.stats.min() == stats.min() && summary.stats.max() == stats.max());
+    assert(summary.stats.mean() == stats.mean());
+    assert(std::fabs(summary.stats.variance() - stats.variance()) < 1e-5f * stats.variance());
+    std::cout << "SUMMARY TEST CORRECT" << std::endl;
+}
+
+template<class Policy>
+void checkPolicy(const char* name) {
+    std::vector<float> f;
+    std::vector<double> d;
+    const int n = 100000;
+    for (int i = 0; i < n; i++) {
+        f.push_back(0.1f + (float) (i % 3) / 100.f);
+        d.push_back(f.back());
+    }
+    double exact = 0;
+    for (float v: f) {
+        exact += v;
+    }
+    double variance = 0;
+    for (float v: f) {
+        variance += (v - exact / n) * (v - exact / n) / n;
+    }
+    std::cout << std::setprecision(6) << name << ": float sum error " << sum<Policy>(f.data(), f.size()) - exact
+              << ", double sum error " << sum<Policy>(d.data(), d.size()) - exact << std::endl;
+
+    double v[] = {2.0, 3.0, 6.0};
+    assert(std::fabs(length<Policy>(v, 3) - 7.0) < 1e-12);
+    float big[] = {3e30f, 4e30f};
+    assert(std::fabs(length<Policy>(big, 2) / 5e30f - 1.f) < 1e-6f);
+
+    float a[] = {1.0, 2.0, 3.0};
+    assert((polynomial<Policy>(3.f, a, 3) == 34.f));
+
+    BasicStatistics<double, Policy> left, right;
+    left.update(d.data(), n / 3);
+    right.update(d.data() + n / 3, n - n / 3);
+    left.merge(right);
+    assert(left.count() == n);
+    assert(std::fabs(left.mean() - exact / n) < 1e-9);
+    assert(std::fabs(left.variance() - variance) < 1e-9);
+}
+
+void checkPolicies() {
+    checkPolicy<NaiveSum>("naive");
+    checkPolicy<KahanSum>("kahan");
+    checkPolicy<WideSum>("wide");
+    checkPolicy<DoubleDoubleSum>("double-double");
+
+    BasicStatistics<float> statistics;
+    for (auto v: {2.f, 4.f, 6.f, 8.f, 10.f}) {
+        statistics.update(v);
+    }
+    assert(statistics.sum() == 30.f && statistics.mean() == 6.f && statistics.variance() == 8.f);
+}
+
+void checkParallel() {
+    std::cout << "Parallel test start" << std::endl;
+    std::vector<float> d(1 << 24);
+    for (size_t i = 0; i < d.size(); i++) {
+        d[i] = (float) (i % 1000) / 7.f - 50.f;
+    }
+    unsigned maxThreads = std::max(4u, std::thread::hardware_concurrency());
+    float expected[4];
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        ParallelReducer reducer(threads);
+        auto start = std::chrono::steady_clock::now();
+        float got[4] = {
+                reducer.dummy_sum(d.data(), d.size()),
+                reducer.kahan_sum(d.data(), d.size()),
+                reducer.pairwise_sum(d.data(), d.size()),
+                reducer.length(d.data(), d.size())
+        };
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        for (int k = 0; k < 4; k++) {
+            if (threads == 1) {
+                expected[k] = got[k];
+            }
+            assert(bs32(*reinterpret_cast<uint32_t*>(&got[k])) == bs32(*reinterpret_cast<uint32_t*>(&expected[k])));
+        }
+        std::cout << threads << " threads: " << std::setprecision(2)
+                  << 4.0 * d.size() * sizeof(float) / seconds / 1e9 << " GB/s" << std::endl;
+    }
+    std::cout << "Parallel test end" << std::endl;
+}
+
+// hw1 <file>: все метрики сырого файла float32 за один проход, без чтения в память.
+int summarizeFile(const char* path) {
+    try {
+        MappedFloats file(path);
+        Summary summary = summarize(file.data(), file.size());
+        std::cout << std::setprecision(9)
+                  << "count " << summary.stats.count() << std::endl
+                  << "sum " << summary.dummy << std::endl
+                  << "kahan " << summary.kahan << std::endl
+                  << "length " << summary.length << std::endl;
+        if (summary.stats.count() > 0) {
+            std::cout << "min " << summary.stats.min() << std::endl
+                      << "max " << summary.stats.max() << std::endl
+                      << "mean " << summary.stats.mean() << std::endl
+                      << "variance " << summary.stats.variance() << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        return summarizeFile(argv[1]);
+    }
     checkPolynomial();
     checkSimpleSums();
     checkKahanSum();
     checkPairwiseSum();
+    checkExactSum();
     checkStats();
     checkLength();
+    checkSummary();
+    checkPolicies();
+    checkParallel();
 }
 
 void checkSimpleSums() {
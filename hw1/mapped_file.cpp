@@ -0,0 +1,52 @@
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFloats::MappedFloats(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(path + ": " + std::strerror(errno));
+    }
+    struct stat info = {};
+    if (fstat(fd, &info) != 0) {
+        int error = errno;
+        close(fd);
+        throw std::runtime_error(path + ": " + std::strerror(error));
+    }
+    bytes = (size_t) info.st_size;
+    if (bytes % sizeof(float) != 0) {
+        close(fd);
+        throw std::runtime_error(path + ": size is not a multiple of sizeof(float)");
+    }
+    if (bytes != 0) {
+        mapping = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            int error = errno;
+            mapping = nullptr;
+            close(fd);
+            throw std::runtime_error(path + ": " + std::strerror(error));
+        }
+        madvise(mapping, bytes, MADV_SEQUENTIAL);
+    }
+    close(fd);
+}
+
+MappedFloats::~MappedFloats() {
+    if (mapping != nullptr) {
+        munmap(mapping, bytes);
+    }
+}
+
+const float* MappedFloats::data() const noexcept {
+    return static_cast<const float*>(mapping);
+}
+
+size_t MappedFloats::size() const noexcept {
+    return bytes / sizeof(float);
+}
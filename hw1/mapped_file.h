@@ -0,0 +1,28 @@
+#ifndef HW1_MAPPED_FILE_H
+#define HW1_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+// Сырой файл float32, отображённый в память только для чтения. Данные не копируются:
+// страницы подгружает ядро по мере обращения.
+class MappedFloats {
+public:
+    explicit MappedFloats(const std::string& path);
+
+    ~MappedFloats();
+
+    MappedFloats(const MappedFloats&) = delete;
+
+    MappedFloats& operator=(const MappedFloats&) = delete;
+
+    const float* data() const noexcept;
+
+    size_t size() const noexcept;
+
+private:
+    void* mapping = nullptr;
+    size_t bytes = 0;
+};
+
+#endif //HW1_MAPPED_FILE_H
@@ -0,0 +1,154 @@
+#include "parallel.h"
+#include "functions.h"
+
+ThreadPool::ThreadPool(unsigned threads) {
+    for (unsigned i = 1; i < threads; i++) {
+        workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker: workers) {
+        worker.join();
+    }
+}
+
+unsigned ThreadPool::size() const noexcept {
+    return (unsigned) workers.size() + 1;
+}
+
+void ThreadPool::run(size_t tasks, const std::function<void(size_t)>& task) {
+    if (workers.empty() || tasks <= 1) {
+        for (size_t i = 0; i < tasks; i++) {
+            task(i);
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &task;
+        jobSize = tasks;
+        next = 0;
+        busy = workers.size();
+        generation++;
+    }
+    wake.notify_all();
+    drain();
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busy == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::drain() {
+    for (size_t i = next++; i < jobSize; i = next++) {
+        (*job)(i);
+    }
+}
+
+void ThreadPool::workerLoop() {
+    unsigned seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+        drain();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy == 0) {
+            done.notify_one();
+        }
+    }
+}
+
+namespace {
+
+    // Balanced tree over the chunk results; its shape depends only on the number of chunks.
+    float treeSum(const float* x, size_t n) {
+        if (n == 1) {
+            return x[0];
+        }
+        size_t half = n / 2;
+        return treeSum(x, half) + treeSum(x + half, n - half);
+    }
+
+}
+
+ParallelReducer::ParallelReducer(unsigned threads) : workers(threads == 0 ? 1 : threads) {
+}
+
+unsigned ParallelReducer::threads() const noexcept {
+    return workers.size();
+}
+
+ThreadPool& ParallelReducer::pool() noexcept {
+    return workers;
+}
+
+const std::vector<float>& ParallelReducer::chunkResults(const float* x, size_t n,
+                                                        float (*kernel)(const float*, size_t)) {
+    size_t chunks = (n + REDUCTION_CHUNK - 1) / REDUCTION_CHUNK;
+    partial.assign(chunks, 0.f);
+    workers.run(chunks, [&](size_t i) {
+        size_t begin = i * REDUCTION_CHUNK;
+        partial[i] = kernel(x + begin, std::min(REDUCTION_CHUNK, n - begin));
+    });
+    return partial;
+}
+
+float ParallelReducer::dummy_sum(const float* x, size_t n) {
+    if (n == 0) {
+        return 0;
+    }
+    auto& sums = chunkResults(x, n, ::dummy_sum);
+    return treeSum(sums.data(), sums.size());
+}
+
+float ParallelReducer::kahan_sum(const float* x, size_t n) {
+    auto& sums = chunkResults(x, n, ::kahan_sum);
+    return ::kahan_sum(sums.data(), sums.size());
+}
+
+float ParallelReducer::pairwise_sum(const float* x, size_t n) {
+    if (n == 0) {
+        return 0;
+    }
+    // Each chunk is its own pairwise tree and treeSum folds the chunk sums, so the order of additions differs
+    // from one pairwise_sum_simd over all n. It depends only on REDUCTION_CHUNK, not on the thread count:
+    // the result is deterministic for a fixed chunk size, not identical to the serial sum.
+    auto& sums = chunkResults(x, n, ::pairwise_sum_simd);
+    return treeSum(sums.data(), sums.size());
+}
+
+float ParallelReducer::length(const float* x, size_t n) {
+    // |x| = |(|x_0|, |x_1|, ...)| over the chunks, so the chunk norms fold with length() itself.
+    auto& norms = chunkResults(x, n, ::length);
+    return ::length(norms.data(), norms.size());
+}
+
+float ParallelReducer::exact_sum(const float* x, size_t n) {
+    size_t chunks = (n + REDUCTION_CHUNK - 1) / REDUCTION_CHUNK;
+    std::vector<ExactAccumulator> sums(std::min<size_t>(chunks, workers.size()));
+    if (sums.empty()) {
+        return 0;
+    }
+    // One accumulator per slot, chunk i goes to slot i % slots: the slots never share an accumulator.
+    workers.run(sums.size(), [&](size_t slot) {
+        for (size_t i = slot; i < chunks; i += sums.size()) {
+            size_t begin = i * REDUCTION_CHUNK;
+            sums[slot].add(x + begin, std::min(REDUCTION_CHUNK, n - begin));
+        }
+    });
+    for (size_t i = 1; i < sums.size(); i++) {
+        sums[0].merge(sums[i]);
+    }
+    return sums[0].value();
+}
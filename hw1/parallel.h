@@ -0,0 +1,76 @@
+#ifndef HW1_PARALLEL_H
+#define HW1_PARALLEL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков: run() раздаёт номера задач [0, tasks) и ждёт, пока все выполнятся.
+// Вызывающий поток тоже работает, так что ThreadPool(1) не создаёт потоков вовсе.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const noexcept;
+
+    void run(size_t tasks, const std::function<void(size_t)>& task);
+
+private:
+    void workerLoop();
+
+    void drain();
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t)>* job = nullptr;
+    size_t jobSize = 0;
+    std::atomic<size_t> next{0};
+    size_t busy = 0;
+    unsigned generation = 0;
+    bool stopping = false;
+};
+
+// Массив режется на куски по REDUCTION_CHUNK элементов независимо от числа потоков,
+// куски считаются в пуле, а частичные результаты складываются по фиксированному дереву.
+// Поэтому результат побитово совпадает при любом числе потоков и любом порядке исполнения.
+const size_t REDUCTION_CHUNK = 1 << 16;
+
+class ParallelReducer {
+public:
+    explicit ParallelReducer(unsigned threads = std::thread::hardware_concurrency());
+
+    unsigned threads() const noexcept;
+
+    float dummy_sum(const float* x, size_t n);
+
+    float kahan_sum(const float* x, size_t n);
+
+    float pairwise_sum(const float* x, size_t n);
+
+    float length(const float* x, size_t n);
+
+    // Точная сумма от порядка не зависит вовсе, куски только сливаются.
+    float exact_sum(const float* x, size_t n);
+
+    ThreadPool& pool() noexcept;
+
+private:
+    const std::vector<float>& chunkResults(const float* x, size_t n, float (*kernel)(const float*, size_t));
+
+    ThreadPool workers;
+    std::vector<float> partial;
+};
+
+#endif //HW1_PARALLEL_H
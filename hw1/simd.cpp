@@ -0,0 +1,1128 @@
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "simd.h"
+
+namespace {
+
+    // Scalar Kahan accumulator used for the lane reduction and for the tails.
+    struct Compensated {
+        float s = 0;
+        float c = 0;
+
+        void add(float x) {
+            float y = x - c;
+            float t = s + y;
+            c = (t - s) - y;
+            s = t;
+        }
+    };
+
+    // Lane i holds the value s[i] - c[i]; fold every lane and the tail into one sum.
+    float combineLanes(const float* s, const float* c, size_t lanes, const float* tail, size_t tailN) {
+        Compensated acc;
+        for (size_t i = 0; i < lanes; i++) {
+            acc.add(s[i]);
+            acc.add(-c[i]);
+        }
+        for (size_t i = 0; i < tailN; i++) {
+            acc.add(tail[i]);
+        }
+        return acc.s;
+    }
+
+    float scalarDummy(const float* x, size_t n) {
+        float sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            sum += x[i];
+        }
+        return sum;
+    }
+
+    float scalarKahan(const float* x, size_t n) {
+        Compensated acc;
+        for (size_t i = 0; i < n; i++) {
+            acc.add(x[i]);
+        }
+        return acc.s;
+    }
+
+    double scalarWide(const float* x, size_t n) {
+        double sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            sum += x[i];
+        }
+        return sum;
+    }
+
+    MagnitudeRange scalarMagnitudes(const float* x, size_t n) {
+        uint32_t low = ~uint32_t(0), high = 0;
+        double sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            uint32_t bits;
+            std::memcpy(&bits, x + i, sizeof(bits));
+            bits &= 0x7fffffff;
+            high = std::max(high, bits);
+            // Zero wraps around to the largest value and never wins the minimum.
+            low = std::min(low, bits - 1);
+            sum += x[i];
+        }
+        return {low + 1, high, sum};
+    }
+
+    double scalarBandSum(const float* x, size_t n, uint32_t low, uint32_t high) {
+        double sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            uint32_t bits;
+            std::memcpy(&bits, x + i, sizeof(bits));
+            bits &= 0x7fffffff;
+            if (bits >= low && bits < high) {
+                sum += x[i];
+            }
+        }
+        return sum;
+    }
+
+    void scalarAdd(float* dst, const float* a, const float* b, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            dst[i] = a[i] + b[i];
+        }
+    }
+
+    // Finishes both moment passes over x[from, n) on top of the partial results of the vector loops.
+    void tailPass1(const float* x, size_t from, size_t n, double& sum, float& lo, float& hi) {
+        for (size_t i = from; i < n; i++) {
+            sum += x[i];
+            lo = std::min(lo, x[i]);
+            hi = std::max(hi, x[i]);
+        }
+    }
+
+    double tailPass2(const float* x, size_t from, size_t n, double mean) {
+        double m2 = 0;
+        for (size_t i = from; i < n; i++) {
+            double d = x[i] - mean;
+            m2 += d * d;
+        }
+        return m2;
+    }
+
+    BlockMoments scalarMoments(const float* x, size_t n) {
+        BlockMoments result = {0, 0, x[0], x[0]};
+        tailPass1(x, 0, n, result.sum, result.min, result.max);
+        result.m2 = tailPass2(x, 0, n, result.sum / (double) n);
+        return result;
+    }
+
+    // Tail of a fused block: everything goes to lane 0, which keeps the lane sums exact as states.
+    void fusedTail(const float* x, size_t from, size_t n, FusedLanes& lanes, BlockMoments& m) {
+        Compensated acc = {lanes.kahanS[0], lanes.kahanC[0]};
+        double squares = 0;
+        for (size_t i = from; i < n; i++) {
+            lanes.dummy[0] += x[i];
+            acc.add(x[i]);
+            squares += (double) x[i] * x[i];
+        }
+        lanes.kahanS[0] = acc.s;
+        lanes.kahanC[0] = acc.c;
+        lanes.sumSquares += squares;
+        tailPass1(x, from, n, m.sum, m.min, m.max);
+    }
+
+    BlockMoments scalarFused(const float* x, size_t n, FusedLanes& lanes) {
+        BlockMoments result = {0, 0, x[0], x[0]};
+        fusedTail(x, 0, n, lanes, result);
+        result.m2 = tailPass2(x, 0, n, result.sum / (double) n);
+        return result;
+    }
+
+    // Blue's scaled sum of squares, constants as in LAPACK's la_constants for single precision.
+    // Every |x| lands in exactly one bin; the small and big bins are rescaled so their squares stay representable.
+    const float BLUE_TSML = 0x1p-63f;
+    const float BLUE_TBIG = 0x1p52f;
+    const float BLUE_SSML = 0x1p75f;
+    const float BLUE_SBIG = 0x1p-76f;
+
+    struct BlueBins {
+        float sml = 0;
+        float med = 0;
+        float big = 0;
+
+        void add(float x) {
+            float ax = std::fabs(x);
+            bool big = ax > BLUE_TBIG;
+            bool sml = ax < BLUE_TSML;
+            float scaled = ax * (big ? BLUE_SBIG : sml ? BLUE_SSML : 1.f);
+            float sq = scaled * scaled;
+            this->big += big ? sq : 0.f;
+            this->sml += sml ? sq : 0.f;
+            med += big || sml ? 0.f : sq;
+        }
+
+        // Combination step of LAPACK xNRM2.
+        float finish() const {
+            float scl, sumsq;
+            if (big > 0) {
+                float total = big;
+                if (med > 0 || std::isnan(med)) {
+                    total += (med * BLUE_SBIG) * BLUE_SBIG;
+                }
+                scl = 1.f / BLUE_SBIG;
+                sumsq = total;
+            } else if (sml > 0) {
+                if (med > 0 || std::isnan(med)) {
+                    float ymed = std::sqrt(med);
+                    float ysml = std::sqrt(sml) / BLUE_SSML;
+                    float ymin = std::min(ymed, ysml);
+                    float ymax = std::max(ymed, ysml);
+                    scl = 1.f;
+                    sumsq = ymax * ymax * (1.f + (ymin / ymax) * (ymin / ymax));
+                } else {
+                    scl = 1.f / BLUE_SSML;
+                    sumsq = sml;
+                }
+            } else {
+                scl = 1.f;
+                sumsq = med;
+            }
+            return scl * std::sqrt(sumsq);
+        }
+    };
+
+    void scalarNorms(const float* x, size_t rows, size_t cols, float* out) {
+        for (size_t r = 0; r < rows; r++, x += cols) {
+            BlueBins bins;
+            for (size_t i = 0; i < cols; i++) {
+                bins.add(x[i]);
+            }
+            out[r] = bins.finish();
+        }
+    }
+
+    float horner(float x, const float* a, size_t n) {
+        float result = a[n - 1];
+        for (size_t i = n - 1; i-- > 0;) {
+            result = std::fma(result, x, a[i]);
+        }
+        return result;
+    }
+
+    // Four independent chains per step hide the fma latency even without vector registers.
+    void scalarPolynomial(const float* x, size_t count, const float* a, size_t n, float* out) {
+        size_t j = 0;
+        for (; j + 4 <= count; j += 4) {
+            float r0 = a[n - 1], r1 = r0, r2 = r0, r3 = r0;
+            for (size_t i = n - 1; i-- > 0;) {
+                r0 = std::fma(r0, x[j], a[i]);
+                r1 = std::fma(r1, x[j + 1], a[i]);
+                r2 = std::fma(r2, x[j + 2], a[i]);
+                r3 = std::fma(r3, x[j + 3], a[i]);
+            }
+            out[j] = r0;
+            out[j + 1] = r1;
+            out[j + 2] = r2;
+            out[j + 3] = r3;
+        }
+        for (; j < count; j++) {
+            out[j] = horner(x[j], a, n);
+        }
+    }
+
+    // ---------------- SSE2 ----------------
+
+    __attribute__((target("sse2")))
+    float sse2Dummy(const float* x, size_t n) {
+        __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps(), s2 = _mm_setzero_ps(), s3 = _mm_setzero_ps();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            s0 = _mm_add_ps(s0, _mm_loadu_ps(x + i));
+            s1 = _mm_add_ps(s1, _mm_loadu_ps(x + i + 4));
+            s2 = _mm_add_ps(s2, _mm_loadu_ps(x + i + 8));
+            s3 = _mm_add_ps(s3, _mm_loadu_ps(x + i + 12));
+        }
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, _mm_add_ps(_mm_add_ps(s0, s1), _mm_add_ps(s2, s3)));
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3] + scalarDummy(x + i, n - i);
+    }
+
+#define KAHAN_STEP(add, sub, s, c, v) \
+    do {                              \
+        auto y = sub(v, c);           \
+        auto t = add(s, y);           \
+        c = sub(sub(t, s), y);        \
+        s = t;                        \
+    } while (0)
+
+    __attribute__((target("sse2")))
+    float sse2Kahan(const float* x, size_t n) {
+        __m128 s[4], c[4];
+        for (int k = 0; k < 4; k++) {
+            s[k] = _mm_setzero_ps();
+            c[k] = _mm_setzero_ps();
+        }
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            for (int k = 0; k < 4; k++) {
+                KAHAN_STEP(_mm_add_ps, _mm_sub_ps, s[k], c[k], _mm_loadu_ps(x + i + 4 * k));
+            }
+        }
+        alignas(16) float ls[16], lc[16];
+        for (int k = 0; k < 4; k++) {
+            _mm_store_ps(ls + 4 * k, s[k]);
+            _mm_store_ps(lc + 4 * k, c[k]);
+        }
+        return combineLanes(ls, lc, 16, x + i, n - i);
+    }
+
+    __attribute__((target("sse2")))
+    double sse2Wide(const float* x, size_t n) {
+        __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd(), s2 = _mm_setzero_pd(), s3 = _mm_setzero_pd();
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m128 a = _mm_loadu_ps(x + i), b = _mm_loadu_ps(x + i + 4);
+            s0 = _mm_add_pd(s0, _mm_cvtps_pd(a));
+            s1 = _mm_add_pd(s1, _mm_cvtps_pd(_mm_movehl_ps(a, a)));
+            s2 = _mm_add_pd(s2, _mm_cvtps_pd(b));
+            s3 = _mm_add_pd(s3, _mm_cvtps_pd(_mm_movehl_ps(b, b)));
+        }
+        alignas(16) double lanes[2];
+        _mm_store_pd(lanes, _mm_add_pd(_mm_add_pd(s0, s1), _mm_add_pd(s2, s3)));
+        return lanes[0] + lanes[1] + scalarWide(x + i, n - i);
+    }
+
+    // |x| bits fit in 31 bits, so the signed compares of SSE2 order them correctly.
+    __attribute__((target("sse2")))
+    double sse2BandSum(const float* x, size_t n, uint32_t low, uint32_t high) {
+        const __m128i abs = _mm_set1_epi32(0x7fffffff);
+        const __m128i below = _mm_set1_epi32((int) low - 1), limit = _mm_set1_epi32((int) high);
+        __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128 v = _mm_loadu_ps(x + i);
+            __m128i bits = _mm_and_si128(_mm_castps_si128(v), abs);
+            __m128i inside = _mm_and_si128(_mm_cmpgt_epi32(bits, below), _mm_cmpgt_epi32(limit, bits));
+            v = _mm_and_ps(v, _mm_castsi128_ps(inside));
+            s0 = _mm_add_pd(s0, _mm_cvtps_pd(v));
+            s1 = _mm_add_pd(s1, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+        }
+        alignas(16) double lanes[2];
+        _mm_store_pd(lanes, _mm_add_pd(s0, s1));
+        return lanes[0] + lanes[1] + scalarBandSum(x + i, n - i, low, high);
+    }
+
+    __attribute__((target("sse2")))
+    void sse2Add(float* dst, const float* a, const float* b, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        }
+        scalarAdd(dst + i, a + i, b + i, n - i);
+    }
+
+    __attribute__((target("sse2")))
+    BlockMoments sse2Moments(const float* x, size_t n) {
+        __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+        __m128 lo = _mm_set1_ps(x[0]), hi = lo;
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128 v = _mm_loadu_ps(x + i);
+            lo = _mm_min_ps(lo, v);
+            hi = _mm_max_ps(hi, v);
+            s0 = _mm_add_pd(s0, _mm_cvtps_pd(v));
+            s1 = _mm_add_pd(s1, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+        }
+        alignas(16) double ls[2];
+        alignas(16) float llo[4], lhi[4];
+        _mm_store_pd(ls, _mm_add_pd(s0, s1));
+        _mm_store_ps(llo, lo);
+        _mm_store_ps(lhi, hi);
+        BlockMoments result = {ls[0] + ls[1], 0, x[0], x[0]};
+        for (int k = 0; k < 4; k++) {
+            result.min = std::min(result.min, llo[k]);
+            result.max = std::max(result.max, lhi[k]);
+        }
+        tailPass1(x, i, n, result.sum, result.min, result.max);
+
+        double mean = result.sum / (double) n;
+        __m128d m = _mm_set1_pd(mean);
+        __m128d q0 = _mm_setzero_pd(), q1 = _mm_setzero_pd();
+        for (i = 0; i + 4 <= n; i += 4) {
+            __m128 v = _mm_loadu_ps(x + i);
+            __m128d d0 = _mm_sub_pd(_mm_cvtps_pd(v), m);
+            __m128d d1 = _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), m);
+            q0 = _mm_add_pd(q0, _mm_mul_pd(d0, d0));
+            q1 = _mm_add_pd(q1, _mm_mul_pd(d1, d1));
+        }
+        _mm_store_pd(ls, _mm_add_pd(q0, q1));
+        result.m2 = ls[0] + ls[1] + tailPass2(x, i, n, mean);
+        return result;
+    }
+
+    __attribute__((target("sse2")))
+    BlockMoments sse2Fused(const float* x, size_t n, FusedLanes& lanes) {
+        __m128 d[2], ks[2], kc[2];
+        for (int k = 0; k < 2; k++) {
+            d[k] = _mm_load_ps(lanes.dummy + 4 * k);
+            ks[k] = _mm_load_ps(lanes.kahanS + 4 * k);
+            kc[k] = _mm_load_ps(lanes.kahanC + 4 * k);
+        }
+        __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd(), q0 = _mm_setzero_pd(), q1 = _mm_setzero_pd();
+        __m128 lo = _mm_set1_ps(x[0]), hi = lo;
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            for (int k = 0; k < 2; k++) {
+                __m128 v = _mm_loadu_ps(x + i + 4 * k);
+                d[k] = _mm_add_ps(d[k], v);
+                KAHAN_STEP(_mm_add_ps, _mm_sub_ps, ks[k], kc[k], v);
+                lo = _mm_min_ps(lo, v);
+                hi = _mm_max_ps(hi, v);
+                __m128d a = _mm_cvtps_pd(v);
+                __m128d b = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+                s0 = _mm_add_pd(s0, a);
+                s1 = _mm_add_pd(s1, b);
+                q0 = _mm_add_pd(q0, _mm_mul_pd(a, a));
+                q1 = _mm_add_pd(q1, _mm_mul_pd(b, b));
+            }
+        }
+        for (int k = 0; k < 2; k++) {
+            _mm_store_ps(lanes.dummy + 4 * k, d[k]);
+            _mm_store_ps(lanes.kahanS + 4 * k, ks[k]);
+            _mm_store_ps(lanes.kahanC + 4 * k, kc[k]);
+        }
+        alignas(16) double ls[2], lq[2];
+        alignas(16) float llo[4], lhi[4];
+        _mm_store_pd(ls, _mm_add_pd(s0, s1));
+        _mm_store_pd(lq, _mm_add_pd(q0, q1));
+        _mm_store_ps(llo, lo);
+        _mm_store_ps(lhi, hi);
+        lanes.sumSquares += lq[0] + lq[1];
+        BlockMoments result = {ls[0] + ls[1], 0, x[0], x[0]};
+        for (int k = 0; k < 4; k++) {
+            result.min = std::min(result.min, llo[k]);
+            result.max = std::max(result.max, lhi[k]);
+        }
+        fusedTail(x, i, n, lanes, result);
+
+        double mean = result.sum / (double) n;
+        __m128d m = _mm_set1_pd(mean);
+        q0 = _mm_setzero_pd();
+        q1 = _mm_setzero_pd();
+        for (i = 0; i + 4 <= n; i += 4) {
+            __m128 v = _mm_loadu_ps(x + i);
+            __m128d d0 = _mm_sub_pd(_mm_cvtps_pd(v), m);
+            __m128d d1 = _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), m);
+            q0 = _mm_add_pd(q0, _mm_mul_pd(d0, d0));
+            q1 = _mm_add_pd(q1, _mm_mul_pd(d1, d1));
+        }
+        _mm_store_pd(ls, _mm_add_pd(q0, q1));
+        result.m2 = ls[0] + ls[1] + tailPass2(x, i, n, mean);
+        return result;
+    }
+
+    __attribute__((target("sse2")))
+    void sse2Norms(const float* x, size_t rows, size_t cols, float* out) {
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        const __m128 tbig = _mm_set1_ps(BLUE_TBIG), tsml = _mm_set1_ps(BLUE_TSML);
+        const __m128 sbig = _mm_set1_ps(BLUE_SBIG), ssml = _mm_set1_ps(BLUE_SSML), one = _mm_set1_ps(1.f);
+        for (size_t r = 0; r < rows; r++, x += cols) {
+            __m128 big = _mm_setzero_ps(), med = _mm_setzero_ps(), sml = _mm_setzero_ps();
+            size_t i = 0;
+            for (; i + 4 <= cols; i += 4) {
+                __m128 ax = _mm_and_ps(_mm_loadu_ps(x + i), absMask);
+                __m128 isBig = _mm_cmpgt_ps(ax, tbig);
+                __m128 isSml = _mm_cmplt_ps(ax, tsml);
+                __m128 notMed = _mm_or_ps(isBig, isSml);
+                __m128 scale = _mm_or_ps(_mm_or_ps(_mm_and_ps(isBig, sbig), _mm_and_ps(isSml, ssml)),
+                                         _mm_andnot_ps(notMed, one));
+                __m128 scaled = _mm_mul_ps(ax, scale);
+                __m128 sq = _mm_mul_ps(scaled, scaled);
+                big = _mm_add_ps(big, _mm_and_ps(isBig, sq));
+                sml = _mm_add_ps(sml, _mm_and_ps(isSml, sq));
+                med = _mm_add_ps(med, _mm_andnot_ps(notMed, sq));
+            }
+            alignas(16) float lb[4], lm[4], ls[4];
+            _mm_store_ps(lb, big);
+            _mm_store_ps(lm, med);
+            _mm_store_ps(ls, sml);
+            BlueBins bins;
+            for (int k = 0; k < 4; k++) {
+                bins.big += lb[k];
+                bins.med += lm[k];
+                bins.sml += ls[k];
+            }
+            for (; i < cols; i++) {
+                bins.add(x[i]);
+            }
+            out[r] = bins.finish();
+        }
+    }
+
+    // ---------------- AVX2 ----------------
+
+    __attribute__((target("avx2")))
+    float avx2Dummy(const float* x, size_t n) {
+        __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps(), s2 = _mm256_setzero_ps(), s3 = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            s0 = _mm256_add_ps(s0, _mm256_loadu_ps(x + i));
+            s1 = _mm256_add_ps(s1, _mm256_loadu_ps(x + i + 8));
+            s2 = _mm256_add_ps(s2, _mm256_loadu_ps(x + i + 16));
+            s3 = _mm256_add_ps(s3, _mm256_loadu_ps(x + i + 24));
+        }
+        __m256 s = _mm256_add_ps(_mm256_add_ps(s0, s1), _mm256_add_ps(s2, s3));
+        __m128 h = _mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1));
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, h);
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3] + scalarDummy(x + i, n - i);
+    }
+
+    __attribute__((target("avx2")))
+    float avx2Kahan(const float* x, size_t n) {
+        __m256 s[4], c[4];
+        for (int k = 0; k < 4; k++) {
+            s[k] = _mm256_setzero_ps();
+            c[k] = _mm256_setzero_ps();
+        }
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            for (int k = 0; k < 4; k++) {
+                KAHAN_STEP(_mm256_add_ps, _mm256_sub_ps, s[k], c[k], _mm256_loadu_ps(x + i + 8 * k));
+            }
+        }
+        alignas(32) float ls[32], lc[32];
+        for (int k = 0; k < 4; k++) {
+            _mm256_store_ps(ls + 8 * k, s[k]);
+            _mm256_store_ps(lc + 8 * k, c[k]);
+        }
+        return combineLanes(ls, lc, 32, x + i, n - i);
+    }
+
+    __attribute__((target("avx2")))
+    double avx2Wide(const float* x, size_t n) {
+        __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd(), s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            __m256 a = _mm256_loadu_ps(x + i), b = _mm256_loadu_ps(x + i + 8);
+            s0 = _mm256_add_pd(s0, _mm256_cvtps_pd(_mm256_castps256_ps128(a)));
+            s1 = _mm256_add_pd(s1, _mm256_cvtps_pd(_mm256_extractf128_ps(a, 1)));
+            s2 = _mm256_add_pd(s2, _mm256_cvtps_pd(_mm256_castps256_ps128(b)));
+            s3 = _mm256_add_pd(s3, _mm256_cvtps_pd(_mm256_extractf128_ps(b, 1)));
+        }
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, _mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3)));
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + scalarWide(x + i, n - i);
+    }
+
+    __attribute__((target("avx2")))
+    MagnitudeRange avx2Magnitudes(const float* x, size_t n) {
+        const __m256i abs = _mm256_set1_epi32(0x7fffffff), one = _mm256_set1_epi32(1);
+        __m256i lo = _mm256_set1_epi32(-1), hi = _mm256_setzero_si256();
+        __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd(), s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            __m256 a = _mm256_loadu_ps(x + i), b = _mm256_loadu_ps(x + i + 8);
+            __m256i ba = _mm256_and_si256(_mm256_castps_si256(a), abs);
+            __m256i bb = _mm256_and_si256(_mm256_castps_si256(b), abs);
+            hi = _mm256_max_epu32(hi, _mm256_max_epu32(ba, bb));
+            lo = _mm256_min_epu32(lo, _mm256_min_epu32(_mm256_sub_epi32(ba, one), _mm256_sub_epi32(bb, one)));
+            s0 = _mm256_add_pd(s0, _mm256_cvtps_pd(_mm256_castps256_ps128(a)));
+            s1 = _mm256_add_pd(s1, _mm256_cvtps_pd(_mm256_extractf128_ps(a, 1)));
+            s2 = _mm256_add_pd(s2, _mm256_cvtps_pd(_mm256_castps256_ps128(b)));
+            s3 = _mm256_add_pd(s3, _mm256_cvtps_pd(_mm256_extractf128_ps(b, 1)));
+        }
+        alignas(32) uint32_t ll[8], lh[8];
+        alignas(32) double lanes[4];
+        _mm256_store_si256((__m256i*) ll, lo);
+        _mm256_store_si256((__m256i*) lh, hi);
+        _mm256_store_pd(lanes, _mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3)));
+        MagnitudeRange range = scalarMagnitudes(x + i, n - i);
+        range.sum += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        uint32_t low = range.lowest - 1;
+        for (int k = 0; k < 8; k++) {
+            low = std::min(low, ll[k]);
+            range.highest = std::max(range.highest, lh[k]);
+        }
+        range.lowest = low + 1;
+        return range;
+    }
+
+    __attribute__((target("avx2")))
+    double avx2BandSum(const float* x, size_t n, uint32_t low, uint32_t high) {
+        const __m256i abs = _mm256_set1_epi32(0x7fffffff);
+        const __m256i below = _mm256_set1_epi32((int) low - 1), limit = _mm256_set1_epi32((int) high);
+        __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd(), s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            __m256 a = _mm256_loadu_ps(x + i), b = _mm256_loadu_ps(x + i + 8);
+            __m256i ba = _mm256_and_si256(_mm256_castps_si256(a), abs);
+            __m256i bb = _mm256_and_si256(_mm256_castps_si256(b), abs);
+            a = _mm256_and_ps(a, _mm256_castsi256_ps(_mm256_and_si256(_mm256_cmpgt_epi32(ba, below),
+                                                                       _mm256_cmpgt_epi32(limit, ba))));
+            b = _mm256_and_ps(b, _mm256_castsi256_ps(_mm256_and_si256(_mm256_cmpgt_epi32(bb, below),
+                                                                       _mm256_cmpgt_epi32(limit, bb))));
+            s0 = _mm256_add_pd(s0, _mm256_cvtps_pd(_mm256_castps256_ps128(a)));
+            s1 = _mm256_add_pd(s1, _mm256_cvtps_pd(_mm256_extractf128_ps(a, 1)));
+            s2 = _mm256_add_pd(s2, _mm256_cvtps_pd(_mm256_castps256_ps128(b)));
+            s3 = _mm256_add_pd(s3, _mm256_cvtps_pd(_mm256_extractf128_ps(b, 1)));
+        }
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, _mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3)));
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + scalarBandSum(x + i, n - i, low, high);
+    }
+
+    __attribute__((target("avx2")))
+    void avx2Add(float* dst, const float* a, const float* b, size_t n) {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        }
+        scalarAdd(dst + i, a + i, b + i, n - i);
+    }
+
+    __attribute__((target("avx2,fma")))
+    BlockMoments avx2Moments(const float* x, size_t n) {
+        __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+        __m256 lo = _mm256_set1_ps(x[0]), hi = lo;
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256 v = _mm256_loadu_ps(x + i);
+            lo = _mm256_min_ps(lo, v);
+            hi = _mm256_max_ps(hi, v);
+            s0 = _mm256_add_pd(s0, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+            s1 = _mm256_add_pd(s1, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+        }
+        alignas(32) double ls[4];
+        alignas(32) float llo[8], lhi[8];
+        _mm256_store_pd(ls, _mm256_add_pd(s0, s1));
+        _mm256_store_ps(llo, lo);
+        _mm256_store_ps(lhi, hi);
+        BlockMoments result = {(ls[0] + ls[1]) + (ls[2] + ls[3]), 0, x[0], x[0]};
+        for (int k = 0; k < 8; k++) {
+            result.min = std::min(result.min, llo[k]);
+            result.max = std::max(result.max, lhi[k]);
+        }
+        tailPass1(x, i, n, result.sum, result.min, result.max);
+
+        double mean = result.sum / (double) n;
+        __m256d m = _mm256_set1_pd(mean);
+        __m256d q0 = _mm256_setzero_pd(), q1 = _mm256_setzero_pd();
+        for (i = 0; i + 8 <= n; i += 8) {
+            __m256 v = _mm256_loadu_ps(x + i);
+            __m256d d0 = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(v)), m);
+            __m256d d1 = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)), m);
+            q0 = _mm256_fmadd_pd(d0, d0, q0);
+            q1 = _mm256_fmadd_pd(d1, d1, q1);
+        }
+        _mm256_store_pd(ls, _mm256_add_pd(q0, q1));
+        result.m2 = (ls[0] + ls[1]) + (ls[2] + ls[3]) + tailPass2(x, i, n, mean);
+        return result;
+    }
+
+    __attribute__((target("avx2,fma")))
+    BlockMoments avx2Fused(const float* x, size_t n, FusedLanes& lanes) {
+        __m256 d[2], ks[2], kc[2];
+        for (int k = 0; k < 2; k++) {
+            d[k] = _mm256_load_ps(lanes.dummy + 8 * k);
+            ks[k] = _mm256_load_ps(lanes.kahanS + 8 * k);
+            kc[k] = _mm256_load_ps(lanes.kahanC + 8 * k);
+        }
+        __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+        __m256d q0 = _mm256_setzero_pd(), q1 = _mm256_setzero_pd();
+        __m256 lo = _mm256_set1_ps(x[0]), hi = lo;
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            for (int k = 0; k < 2; k++) {
+                __m256 v = _mm256_loadu_ps(x + i + 8 * k);
+                d[k] = _mm256_add_ps(d[k], v);
+                KAHAN_STEP(_mm256_add_ps, _mm256_sub_ps, ks[k], kc[k], v);
+                lo = _mm256_min_ps(lo, v);
+                hi = _mm256_max_ps(hi, v);
+                __m256d a = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+                __m256d b = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+                s0 = _mm256_add_pd(s0, a);
+                s1 = _mm256_add_pd(s1, b);
+                q0 = _mm256_fmadd_pd(a, a, q0);
+                q1 = _mm256_fmadd_pd(b, b, q1);
+            }
+        }
+        for (int k = 0; k < 2; k++) {
+            _mm256_store_ps(lanes.dummy + 8 * k, d[k]);
+            _mm256_store_ps(lanes.kahanS + 8 * k, ks[k]);
+            _mm256_store_ps(lanes.kahanC + 8 * k, kc[k]);
+        }
+        alignas(32) double ls[4], lq[4];
+        alignas(32) float llo[8], lhi[8];
+        _mm256_store_pd(ls, _mm256_add_pd(s0, s1));
+        _mm256_store_pd(lq, _mm256_add_pd(q0, q1));
+        _mm256_store_ps(llo, lo);
+        _mm256_store_ps(lhi, hi);
+        lanes.sumSquares += (lq[0] + lq[1]) + (lq[2] + lq[3]);
+        BlockMoments result = {(ls[0] + ls[1]) + (ls[2] + ls[3]), 0, x[0], x[0]};
+        for (int k = 0; k < 8; k++) {
+            result.min = std::min(result.min, llo[k]);
+            result.max = std::max(result.max, lhi[k]);
+        }
+        fusedTail(x, i, n, lanes, result);
+
+        double mean = result.sum / (double) n;
+        __m256d m = _mm256_set1_pd(mean);
+        q0 = _mm256_setzero_pd();
+        q1 = _mm256_setzero_pd();
+        for (i = 0; i + 8 <= n; i += 8) {
+            __m256 v = _mm256_loadu_ps(x + i);
+            __m256d d0 = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(v)), m);
+            __m256d d1 = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)), m);
+            q0 = _mm256_fmadd_pd(d0, d0, q0);
+            q1 = _mm256_fmadd_pd(d1, d1, q1);
+        }
+        _mm256_store_pd(ls, _mm256_add_pd(q0, q1));
+        result.m2 = (ls[0] + ls[1]) + (ls[2] + ls[3]) + tailPass2(x, i, n, mean);
+        return result;
+    }
+
+    struct Avx2Bins {
+        __m256 big, med, sml;
+    };
+
+    __attribute__((target("avx2,fma")))
+    inline void avx2BlueAdd(Avx2Bins& bins, __m256 v) {
+        const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+        __m256 ax = _mm256_and_ps(v, absMask);
+        __m256 isBig = _mm256_cmp_ps(ax, _mm256_set1_ps(BLUE_TBIG), _CMP_GT_OQ);
+        __m256 isSml = _mm256_cmp_ps(ax, _mm256_set1_ps(BLUE_TSML), _CMP_LT_OQ);
+        __m256 scale = _mm256_blendv_ps(_mm256_blendv_ps(_mm256_set1_ps(1.f), _mm256_set1_ps(BLUE_SSML), isSml),
+                                        _mm256_set1_ps(BLUE_SBIG), isBig);
+        __m256 scaled = _mm256_mul_ps(ax, scale);
+        __m256 sq = _mm256_mul_ps(scaled, scaled);
+        bins.big = _mm256_add_ps(bins.big, _mm256_and_ps(isBig, sq));
+        bins.sml = _mm256_add_ps(bins.sml, _mm256_and_ps(isSml, sq));
+        bins.med = _mm256_add_ps(bins.med, _mm256_andnot_ps(_mm256_or_ps(isBig, isSml), sq));
+    }
+
+    __attribute__((target("avx2,fma")))
+    inline float avx2Hsum(__m256 v) {
+        __m128 h = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+        h = _mm_add_ss(h, _mm_movehdup_ps(h));
+        return _mm_cvtss_f32(h);
+    }
+
+    __attribute__((target("avx2,fma")))
+    void avx2Norms(const float* x, size_t rows, size_t cols, float* out) {
+        alignas(32) static const int tailMask[16] = {-1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0};
+        for (size_t r = 0; r < rows; r++, x += cols) {
+            Avx2Bins a = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+            Avx2Bins b = a;
+            size_t i = 0;
+            for (; i + 16 <= cols; i += 16) {
+                avx2BlueAdd(a, _mm256_loadu_ps(x + i));
+                avx2BlueAdd(b, _mm256_loadu_ps(x + i + 8));
+            }
+            for (; i < cols; i += 8) {
+                size_t left = std::min<size_t>(8, cols - i);
+                __m256i mask = _mm256_loadu_si256((const __m256i*) (tailMask + 8 - left));
+                avx2BlueAdd(a, _mm256_maskload_ps(x + i, mask));
+            }
+            BlueBins bins;
+            bins.big = avx2Hsum(_mm256_add_ps(a.big, b.big));
+            bins.med = avx2Hsum(_mm256_add_ps(a.med, b.med));
+            bins.sml = avx2Hsum(_mm256_add_ps(a.sml, b.sml));
+            out[r] = bins.finish();
+        }
+    }
+
+    __attribute__((target("avx2,fma")))
+    void avx2Polynomial(const float* x, size_t count, const float* a, size_t n, float* out) {
+        size_t j = 0;
+        for (; j + 32 <= count; j += 32) {
+            __m256 x0 = _mm256_loadu_ps(x + j), x1 = _mm256_loadu_ps(x + j + 8);
+            __m256 x2 = _mm256_loadu_ps(x + j + 16), x3 = _mm256_loadu_ps(x + j + 24);
+            __m256 r0 = _mm256_set1_ps(a[n - 1]), r1 = r0, r2 = r0, r3 = r0;
+            for (size_t i = n - 1; i-- > 0;) {
+                __m256 c = _mm256_set1_ps(a[i]);
+                r0 = _mm256_fmadd_ps(r0, x0, c);
+                r1 = _mm256_fmadd_ps(r1, x1, c);
+                r2 = _mm256_fmadd_ps(r2, x2, c);
+                r3 = _mm256_fmadd_ps(r3, x3, c);
+            }
+            _mm256_storeu_ps(out + j, r0);
+            _mm256_storeu_ps(out + j + 8, r1);
+            _mm256_storeu_ps(out + j + 16, r2);
+            _mm256_storeu_ps(out + j + 24, r3);
+        }
+        for (; j + 8 <= count; j += 8) {
+            __m256 xv = _mm256_loadu_ps(x + j);
+            __m256 r = _mm256_set1_ps(a[n - 1]);
+            for (size_t i = n - 1; i-- > 0;) {
+                r = _mm256_fmadd_ps(r, xv, _mm256_set1_ps(a[i]));
+            }
+            _mm256_storeu_ps(out + j, r);
+        }
+        scalarPolynomial(x + j, count - j, a, n, out + j);
+    }
+
+    // ---------------- AVX-512 ----------------
+
+    __attribute__((target("avx512f")))
+    float avx512Dummy(const float* x, size_t n) {
+        __m512 s0 = _mm512_setzero_ps(), s1 = _mm512_setzero_ps(), s2 = _mm512_setzero_ps(), s3 = _mm512_setzero_ps();
+        size_t i = 0;
+        for (; i + 64 <= n; i += 64) {
+            s0 = _mm512_add_ps(s0, _mm512_loadu_ps(x + i));
+            s1 = _mm512_add_ps(s1, _mm512_loadu_ps(x + i + 16));
+            s2 = _mm512_add_ps(s2, _mm512_loadu_ps(x + i + 32));
+            s3 = _mm512_add_ps(s3, _mm512_loadu_ps(x + i + 48));
+        }
+        __m512 s = _mm512_add_ps(_mm512_add_ps(s0, s1), _mm512_add_ps(s2, s3));
+        return _mm512_reduce_add_ps(s) + scalarDummy(x + i, n - i);
+    }
+
+    __attribute__((target("avx512f")))
+    float avx512Kahan(const float* x, size_t n) {
+        __m512 s[4], c[4];
+        for (int k = 0; k < 4; k++) {
+            s[k] = _mm512_setzero_ps();
+            c[k] = _mm512_setzero_ps();
+        }
+        size_t i = 0;
+        for (; i + 64 <= n; i += 64) {
+            for (int k = 0; k < 4; k++) {
+                KAHAN_STEP(_mm512_add_ps, _mm512_sub_ps, s[k], c[k], _mm512_loadu_ps(x + i + 16 * k));
+            }
+        }
+        alignas(64) float ls[64], lc[64];
+        for (int k = 0; k < 4; k++) {
+            _mm512_store_ps(ls + 16 * k, s[k]);
+            _mm512_store_ps(lc + 16 * k, c[k]);
+        }
+        return combineLanes(ls, lc, 64, x + i, n - i);
+    }
+
+    __attribute__((target("avx512f")))
+    double avx512Wide(const float* x, size_t n) {
+        __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd(), s2 = _mm512_setzero_pd(), s3 = _mm512_setzero_pd();
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            __m512 a = _mm512_loadu_ps(x + i), b = _mm512_loadu_ps(x + i + 16);
+            s0 = _mm512_add_pd(s0, _mm512_cvtps_pd(_mm512_castps512_ps256(a)));
+            s1 = _mm512_add_pd(s1, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(a), 1))));
+            s2 = _mm512_add_pd(s2, _mm512_cvtps_pd(_mm512_castps512_ps256(b)));
+            s3 = _mm512_add_pd(s3, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(b), 1))));
+        }
+        return _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(s0, s1), _mm512_add_pd(s2, s3)))
+               + scalarWide(x + i, n - i);
+    }
+
+    __attribute__((target("avx512f")))
+    MagnitudeRange avx512Magnitudes(const float* x, size_t n) {
+        const __m512i abs = _mm512_set1_epi32(0x7fffffff), one = _mm512_set1_epi32(1);
+        __m512i lo = _mm512_set1_epi32(-1), hi = _mm512_setzero_si512();
+        __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd(), s2 = _mm512_setzero_pd(), s3 = _mm512_setzero_pd();
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            __m512 a = _mm512_loadu_ps(x + i), b = _mm512_loadu_ps(x + i + 16);
+            __m512i ba = _mm512_and_si512(_mm512_castps_si512(a), abs);
+            __m512i bb = _mm512_and_si512(_mm512_castps_si512(b), abs);
+            hi = _mm512_max_epu32(hi, _mm512_max_epu32(ba, bb));
+            lo = _mm512_min_epu32(lo, _mm512_min_epu32(_mm512_sub_epi32(ba, one), _mm512_sub_epi32(bb, one)));
+            s0 = _mm512_add_pd(s0, _mm512_cvtps_pd(_mm512_castps512_ps256(a)));
+            s1 = _mm512_add_pd(s1, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(a), 1))));
+            s2 = _mm512_add_pd(s2, _mm512_cvtps_pd(_mm512_castps512_ps256(b)));
+            s3 = _mm512_add_pd(s3, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(b), 1))));
+        }
+        MagnitudeRange range = scalarMagnitudes(x + i, n - i);
+        range.sum += _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(s0, s1), _mm512_add_pd(s2, s3)));
+        range.lowest = std::min(range.lowest - 1, (uint32_t) _mm512_reduce_min_epu32(lo)) + 1;
+        range.highest = std::max(range.highest, (uint32_t) _mm512_reduce_max_epu32(hi));
+        return range;
+    }
+
+    __attribute__((target("avx512f")))
+    double avx512BandSum(const float* x, size_t n, uint32_t low, uint32_t high) {
+        const __m512i abs = _mm512_set1_epi32(0x7fffffff);
+        const __m512i from = _mm512_set1_epi32((int) low), limit = _mm512_set1_epi32((int) high);
+        __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd(), s2 = _mm512_setzero_pd(), s3 = _mm512_setzero_pd();
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            __m512 a = _mm512_loadu_ps(x + i), b = _mm512_loadu_ps(x + i + 16);
+            __m512i ba = _mm512_and_si512(_mm512_castps_si512(a), abs);
+            __m512i bb = _mm512_and_si512(_mm512_castps_si512(b), abs);
+            a = _mm512_maskz_mov_ps(_mm512_cmpge_epu32_mask(ba, from) & _mm512_cmplt_epu32_mask(ba, limit), a);
+            b = _mm512_maskz_mov_ps(_mm512_cmpge_epu32_mask(bb, from) & _mm512_cmplt_epu32_mask(bb, limit), b);
+            s0 = _mm512_add_pd(s0, _mm512_cvtps_pd(_mm512_castps512_ps256(a)));
+            s1 = _mm512_add_pd(s1, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(a), 1))));
+            s2 = _mm512_add_pd(s2, _mm512_cvtps_pd(_mm512_castps512_ps256(b)));
+            s3 = _mm512_add_pd(s3, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(b), 1))));
+        }
+        return _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(s0, s1), _mm512_add_pd(s2, s3)))
+               + scalarBandSum(x + i, n - i, low, high);
+    }
+
+    __attribute__((target("avx512f")))
+    void avx512Add(float* dst, const float* a, const float* b, size_t n) {
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            _mm512_storeu_ps(dst + i, _mm512_add_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i)));
+        }
+        scalarAdd(dst + i, a + i, b + i, n - i);
+    }
+
+    __attribute__((target("avx512f")))
+    BlockMoments avx512Moments(const float* x, size_t n) {
+        __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+        __m512 lo = _mm512_set1_ps(x[0]), hi = lo;
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            __m512 v = _mm512_loadu_ps(x + i);
+            lo = _mm512_min_ps(lo, v);
+            hi = _mm512_max_ps(hi, v);
+            s0 = _mm512_add_pd(s0, _mm512_cvtps_pd(_mm512_castps512_ps256(v)));
+            s1 = _mm512_add_pd(s1, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1))));
+        }
+        BlockMoments result = {_mm512_reduce_add_pd(_mm512_add_pd(s0, s1)), 0,
+                               std::min(x[0], _mm512_reduce_min_ps(lo)), std::max(x[0], _mm512_reduce_max_ps(hi))};
+        tailPass1(x, i, n, result.sum, result.min, result.max);
+
+        double mean = result.sum / (double) n;
+        __m512d m = _mm512_set1_pd(mean);
+        __m512d q0 = _mm512_setzero_pd(), q1 = _mm512_setzero_pd();
+        for (i = 0; i + 16 <= n; i += 16) {
+            __m512 v = _mm512_loadu_ps(x + i);
+            __m512d d0 = _mm512_sub_pd(_mm512_cvtps_pd(_mm512_castps512_ps256(v)), m);
+            __m512d d1 = _mm512_sub_pd(
+                    _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1))), m);
+            q0 = _mm512_fmadd_pd(d0, d0, q0);
+            q1 = _mm512_fmadd_pd(d1, d1, q1);
+        }
+        result.m2 = _mm512_reduce_add_pd(_mm512_add_pd(q0, q1)) + tailPass2(x, i, n, mean);
+        return result;
+    }
+
+    __attribute__((target("avx512f")))
+    BlockMoments avx512Fused(const float* x, size_t n, FusedLanes& lanes) {
+        __m512 d[2], ks[2], kc[2];
+        for (int k = 0; k < 2; k++) {
+            d[k] = _mm512_load_ps(lanes.dummy + 16 * k);
+            ks[k] = _mm512_load_ps(lanes.kahanS + 16 * k);
+            kc[k] = _mm512_load_ps(lanes.kahanC + 16 * k);
+        }
+        __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+        __m512d q0 = _mm512_setzero_pd(), q1 = _mm512_setzero_pd();
+        __m512 lo = _mm512_set1_ps(x[0]), hi = lo;
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            for (int k = 0; k < 2; k++) {
+                __m512 v = _mm512_loadu_ps(x + i + 16 * k);
+                d[k] = _mm512_add_ps(d[k], v);
+                KAHAN_STEP(_mm512_add_ps, _mm512_sub_ps, ks[k], kc[k], v);
+                lo = _mm512_min_ps(lo, v);
+                hi = _mm512_max_ps(hi, v);
+                __m512d a = _mm512_cvtps_pd(_mm512_castps512_ps256(v));
+                __m512d b = _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1)));
+                s0 = _mm512_add_pd(s0, a);
+                s1 = _mm512_add_pd(s1, b);
+                q0 = _mm512_fmadd_pd(a, a, q0);
+                q1 = _mm512_fmadd_pd(b, b, q1);
+            }
+        }
+        for (int k = 0; k < 2; k++) {
+            _mm512_store_ps(lanes.dummy + 16 * k, d[k]);
+            _mm512_store_ps(lanes.kahanS + 16 * k, ks[k]);
+            _mm512_store_ps(lanes.kahanC + 16 * k, kc[k]);
+        }
+        lanes.sumSquares += _mm512_reduce_add_pd(_mm512_add_pd(q0, q1));
+        BlockMoments result = {_mm512_reduce_add_pd(_mm512_add_pd(s0, s1)), 0,
+                               std::min(x[0], _mm512_reduce_min_ps(lo)), std::max(x[0], _mm512_reduce_max_ps(hi))};
+        fusedTail(x, i, n, lanes, result);
+
+        double mean = result.sum / (double) n;
+        __m512d m = _mm512_set1_pd(mean);
+        q0 = _mm512_setzero_pd();
+        q1 = _mm512_setzero_pd();
+        for (i = 0; i + 16 <= n; i += 16) {
+            __m512 v = _mm512_loadu_ps(x + i);
+            __m512d d0 = _mm512_sub_pd(_mm512_cvtps_pd(_mm512_castps512_ps256(v)), m);
+            __m512d d1 = _mm512_sub_pd(
+                    _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1))), m);
+            q0 = _mm512_fmadd_pd(d0, d0, q0);
+            q1 = _mm512_fmadd_pd(d1, d1, q1);
+        }
+        result.m2 = _mm512_reduce_add_pd(_mm512_add_pd(q0, q1)) + tailPass2(x, i, n, mean);
+        return result;
+    }
+
+    struct Avx512Bins {
+        __m512 big, med, sml;
+    };
+
+    __attribute__((target("avx512f")))
+    inline void avx512BlueAdd(Avx512Bins& bins, __m512 v) {
+        __m512 ax = _mm512_abs_ps(v);
+        __mmask16 isBig = _mm512_cmp_ps_mask(ax, _mm512_set1_ps(BLUE_TBIG), _CMP_GT_OQ);
+        __mmask16 isSml = _mm512_cmp_ps_mask(ax, _mm512_set1_ps(BLUE_TSML), _CMP_LT_OQ);
+        __m512 scale = _mm512_mask_blend_ps(isSml, _mm512_set1_ps(1.f), _mm512_set1_ps(BLUE_SSML));
+        scale = _mm512_mask_blend_ps(isBig, scale, _mm512_set1_ps(BLUE_SBIG));
+        __m512 scaled = _mm512_mul_ps(ax, scale);
+        __m512 sq = _mm512_mul_ps(scaled, scaled);
+        bins.big = _mm512_mask_add_ps(bins.big, isBig, bins.big, sq);
+        bins.sml = _mm512_mask_add_ps(bins.sml, isSml, bins.sml, sq);
+        bins.med = _mm512_mask_add_ps(bins.med, (__mmask16) ~(isBig | isSml), bins.med, sq);
+    }
+
+    __attribute__((target("avx512f")))
+    void avx512Norms(const float* x, size_t rows, size_t cols, float* out) {
+        for (size_t r = 0; r < rows; r++, x += cols) {
+            Avx512Bins a = {_mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps()};
+            Avx512Bins b = a;
+            size_t i = 0;
+            for (; i + 32 <= cols; i += 32) {
+                avx512BlueAdd(a, _mm512_loadu_ps(x + i));
+                avx512BlueAdd(b, _mm512_loadu_ps(x + i + 16));
+            }
+            for (; i < cols; i += 16) {
+                size_t left = std::min<size_t>(16, cols - i);
+                avx512BlueAdd(a, _mm512_maskz_loadu_ps((__mmask16) ((1u << left) - 1), x + i));
+            }
+            BlueBins bins;
+            bins.big = _mm512_reduce_add_ps(_mm512_add_ps(a.big, b.big));
+            bins.med = _mm512_reduce_add_ps(_mm512_add_ps(a.med, b.med));
+            bins.sml = _mm512_reduce_add_ps(_mm512_add_ps(a.sml, b.sml));
+            out[r] = bins.finish();
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    void avx512Polynomial(const float* x, size_t count, const float* a, size_t n, float* out) {
+        size_t j = 0;
+        for (; j + 64 <= count; j += 64) {
+            __m512 x0 = _mm512_loadu_ps(x + j), x1 = _mm512_loadu_ps(x + j + 16);
+            __m512 x2 = _mm512_loadu_ps(x + j + 32), x3 = _mm512_loadu_ps(x + j + 48);
+            __m512 r0 = _mm512_set1_ps(a[n - 1]), r1 = r0, r2 = r0, r3 = r0;
+            for (size_t i = n - 1; i-- > 0;) {
+                __m512 c = _mm512_set1_ps(a[i]);
+                r0 = _mm512_fmadd_ps(r0, x0, c);
+                r1 = _mm512_fmadd_ps(r1, x1, c);
+                r2 = _mm512_fmadd_ps(r2, x2, c);
+                r3 = _mm512_fmadd_ps(r3, x3, c);
+            }
+            _mm512_storeu_ps(out + j, r0);
+            _mm512_storeu_ps(out + j + 16, r1);
+            _mm512_storeu_ps(out + j + 32, r2);
+            _mm512_storeu_ps(out + j + 48, r3);
+        }
+        for (; j < count; j += 16) {
+            __mmask16 mask = (__mmask16) ((1u << std::min<size_t>(16, count - j)) - 1);
+            __m512 xv = _mm512_maskz_loadu_ps(mask, x + j);
+            __m512 r = _mm512_set1_ps(a[n - 1]);
+            for (size_t i = n - 1; i-- > 0;) {
+                r = _mm512_fmadd_ps(r, xv, _mm512_set1_ps(a[i]));
+            }
+            _mm512_mask_storeu_ps(out + j, mask, r);
+        }
+    }
+
+#undef KAHAN_STEP
+
+    const SumKernels scalarKernels = {"scalar", scalarDummy, scalarKahan, scalarWide, scalarAdd, scalarMoments,
+                                      scalarFused, scalarNorms, scalarPolynomial, scalarMagnitudes, scalarBandSum};
+    // SSE2 has no fma instruction; the scalar Horner keeps the exactly-rounded fma of the other variants.
+    // Nor has it 32-bit integer min and max, so the magnitude range stays scalar too.
+    const SumKernels sse2Kernels = {"sse2", sse2Dummy, sse2Kahan, sse2Wide, sse2Add, sse2Moments,
+                                    sse2Fused, sse2Norms, scalarPolynomial, scalarMagnitudes, sse2BandSum};
+    const SumKernels avx2Kernels = {"avx2", avx2Dummy, avx2Kahan, avx2Wide, avx2Add, avx2Moments,
+                                    avx2Fused, avx2Norms, avx2Polynomial, avx2Magnitudes, avx2BandSum};
+    const SumKernels avx512Kernels = {"avx512", avx512Dummy, avx512Kahan, avx512Wide, avx512Add, avx512Moments,
+                                      avx512Fused, avx512Norms, avx512Polynomial, avx512Magnitudes, avx512BandSum};
+}
+
+namespace {
+
+    // Pairwise tree over one block: the first level reads the caller's data, the rest fold the scratch in place.
+    float blockSum(const SumKernels& kernels, const float* x, size_t len, float* scratch) {
+        size_t half = len / 2;
+        size_t off = len - half;
+        kernels.add(scratch, x, x + off, half);
+        if (off != half) {
+            scratch[half] = x[half];
+        }
+        len = off;
+        while (len > 1) {
+            half = len / 2;
+            off = len - half;
+            kernels.add(scratch, scratch, scratch + off, half);
+            len = off;
+        }
+        return scratch[0];
+    }
+
+}
+
+float pairwiseSum(const SumKernels& kernels, const float* x, size_t n) {
+    if (n == 0) {
+        return 0;
+    }
+    float scratch[PAIRWISE_BLOCK];
+    // Binary counter over block sums: partial[k] covers 2^level[k] blocks, levels strictly decrease,
+    // so the stack never holds more than log2(n / PAIRWISE_BLOCK) + 1 entries.
+    float partial[64];
+    int level[64];
+    int top = 0;
+    for (size_t begin = 0; begin < n; begin += PAIRWISE_BLOCK) {
+        size_t len = std::min(PAIRWISE_BLOCK, n - begin);
+        float sum = blockSum(kernels, x + begin, len, scratch);
+        int lvl = 0;
+        while (top > 0 && level[top - 1] == lvl) {
+            sum = partial[--top] + sum;
+            lvl++;
+        }
+        partial[top] = sum;
+        level[top] = lvl;
+        top++;
+    }
+    float sum = partial[--top];
+    while (top > 0) {
+        sum = partial[--top] + sum;
+    }
+    return sum;
+}
+
+FusedTotals finishFused(const FusedLanes& lanes) {
+    FusedTotals totals = {0, 0, lanes.sumSquares};
+    for (size_t i = 0; i < FUSED_LANES; i++) {
+        totals.dummy += lanes.dummy[i];
+    }
+    totals.kahan = combineLanes(lanes.kahanS, lanes.kahanC, FUSED_LANES, nullptr, 0);
+    return totals;
+}
+
+size_t supportedKernels(const SumKernels** out, size_t capacity) {
+    __builtin_cpu_init();
+    const SumKernels* all[4];
+    size_t count = 0;
+    all[count++] = &scalarKernels;
+    if (__builtin_cpu_supports("sse2")) {
+        all[count++] = &sse2Kernels;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        all[count++] = &avx2Kernels;
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        all[count++] = &avx512Kernels;
+    }
+    size_t written = count < capacity ? count : capacity;
+    for (size_t i = 0; i < written; i++) {
+        out[i] = all[i];
+    }
+    return count;
+}
+
+const SumKernels& activeKernels() {
+    static const SumKernels* chosen = [] {
+        const SumKernels* all[4];
+        size_t count = supportedKernels(all, 4);
+        return all[count - 1];
+    }();
+    return *chosen;
+}
@@ -0,0 +1,76 @@
+#ifndef HW1_SIMD_H
+#define HW1_SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Сумма, минимум, максимум и сумма квадратов отклонений от среднего для одного блока.
+struct BlockMoments {
+    double sum;
+    double m2;
+    float min;
+    float max;
+};
+
+// Состояние слитного прохода, которое переносится между блоками: дорожки наивной суммы и
+// суммы Кэхэна (сколько их занято, зависит от ширины вектора) и сумма квадратов в double.
+// Квадрат любого float помещается в double без переполнения и потери денормалов.
+const size_t FUSED_LANES = 32;
+
+struct FusedLanes {
+    alignas(64) float dummy[FUSED_LANES];
+    alignas(64) float kahanS[FUSED_LANES];
+    alignas(64) float kahanC[FUSED_LANES];
+    double sumSquares;
+};
+
+struct FusedTotals {
+    float dummy;
+    float kahan;
+    double sumSquares;
+};
+
+// Битовые образы наименьшего ненулевого и наибольшего |x[i]| блока (0 и 0, если блок нулевой)
+// и сумма блока в double в любом порядке: точная, если все порядки блока в одной полосе точной суммы.
+struct MagnitudeRange {
+    uint32_t lowest;
+    uint32_t highest;
+    double sum;
+};
+
+// Векторные реализации сумм под конкретный набор инструкций.
+struct SumKernels {
+    const char* name;
+    float (*dummy)(const float* x, size_t n);
+    float (*kahan)(const float* x, size_t n);
+    double (*wide)(const float* x, size_t n); // сумма с накоплением в double
+    void (*add)(float* dst, const float* a, const float* b, size_t n); // dst[i] = a[i] + b[i]
+    BlockMoments (*moments)(const float* x, size_t n);                 // n > 0, два прохода в double
+    // n > 0: моменты блока, а суммы и квадраты копятся в lanes. Второй проход идёт по блоку из кеша.
+    BlockMoments (*fused)(const float* x, size_t n, FusedLanes& lanes);
+    // Нормы rows строк длины cols, лежащих подряд, по алгоритму Блу (без ветвлений).
+    void (*norms)(const float* x, size_t rows, size_t cols, float* out);
+    // Схема Горнера с одним набором коэффициентов a[0..n) сразу для count точек, n > 0.
+    void (*polynomial)(const float* x, size_t count, const float* a, size_t n, float* out);
+    MagnitudeRange (*magnitudes)(const float* x, size_t n);
+    // Сумма в double тех x[i], у которых битовый образ |x[i]| в [low, high); порядок сложения любой.
+    double (*bandSum)(const float* x, size_t n, uint32_t low, uint32_t high);
+};
+
+// Лучший набор, поддерживаемый процессором; выбирается один раз.
+const SumKernels& activeKernels();
+
+// Попарная сумма блоками по PAIRWISE_BLOCK элементов, вход не портится.
+// Дополнительная память -- один блок на стеке и O(log n) частичных сумм.
+const size_t PAIRWISE_BLOCK = 1024;
+
+float pairwiseSum(const SumKernels& kernels, const float* x, size_t n);
+
+// Сворачивает дорожки слитного прохода в итоговые суммы.
+FusedTotals finishFused(const FusedLanes& lanes);
+
+// Все наборы, которые процессор умеет исполнять (последний -- самый широкий).
+// Возвращает их количество; нужен для сравнения вариантов между собой.
+size_t supportedKernels(const SumKernels** out, size_t capacity);
+
+#endif //HW1_SIMD_H
@@ -1,67 +1,85 @@
 #include <cmath>
 #include <iostream>
 #include "functions.h"
+#include "simd.h"
+#include "accumulators.h"
 
-float polynomial(float x, const float* a, int n) {
+float polynomial(float x, const float* a, size_t n) {
+    if (n == 0) {
+        return 0;
+    }
     float result = a[n - 1];
-    for (int i = n - 2; i >= 0; i--) {
+    for (size_t i = n - 1; i-- > 0;) {
         result = std::fma(result, x, a[i]);
     }
     return result;
 }
 
-#pragma GCC push_options
-#pragma GCC optimize ("O0")
-
-float kahan_sum(const float* x, int n) {
-    float s = 0;
-    float c = 0;
-    for (int i = 0; i < n; i++) {
-        float y = x[i] - c;
-        float t = s + y;
-        c = (t - s) - y;
-        s = t;
+void polynomial(const float* x, size_t count, const float* a, size_t n, float* out) {
+    if (n == 0) {
+        std::fill(out, out + count, 0.f);
+        return;
     }
-    return s;
+    activeKernels().polynomial(x, count, a, n, out);
 }
 
-#pragma GCC pop_options
-
-#pragma GCC push_options
-//#pragma GCC optimize ("O3")
-
-#define print(x, y) std::cout << (x) <<" " << y << std::endl;
-
-float pairwise_sum_simd(float* x, int n) {
-    int len = n;
+namespace {
 
-    while (len > 1) {
-        int i = 0;
-        for (; i * 2 + 7 < len; i += 4) {
-            x[i + 0] = x[i * 2 + 0] + x[i * 2 + 4];
-            x[i + 1] = x[i * 2 + 1] + x[i * 2 + 5];
-            x[i + 2] = x[i * 2 + 2] + x[i * 2 + 6];
-            x[i + 3] = x[i * 2 + 3] + x[i * 2 + 7];
+    // p(x) = low(x) + x^h * high(x) with h = 2^k the largest power of two below n; powers[k] = x^(2^k).
+    float estrin(const float* a, size_t n, float x, const float* powers) {
+        if (n == 1) {
+            return a[0];
         }
-        for (; i * 2 + 1 < len; i++) {
-            x[i] = x[i * 2] + x[i * 2 + 1];
+        if (n == 2) {
+            return std::fma(a[1], x, a[0]);
         }
-        if (len % 2 == 1) {
-            x[len / 2] = x[len - 1];
+        int k = 0;
+        while ((size_t(2) << k) < n) {
+            k++;
         }
-        len = (len + 1) / 2;
+        size_t h = size_t(1) << k;
+        return std::fma(estrin(a + h, n - h, x, powers), powers[k], estrin(a, h, x, powers));
     }
-    return x[0];
-}
 
-#pragma GCC pop_options
+}
 
-float dummy_sum(const float* x, int n) {
-    float sum = 0;
-    for (int i = 0; i < n; i++) {
-        sum += x[i];
+float polynomial_estrin(float x, const float* a, size_t n) {
+    if (n == 0) {
+        return 0;
+    }
+    float powers[64];
+    powers[0] = x;
+    for (int k = 1; (size_t(1) << k) < n; k++) {
+        powers[k] = powers[k - 1] * powers[k - 1];
     }
-    return sum;
+    return estrin(a, n, x, powers);
+}
+
+float kahan_sum(const float* x, size_t n) {
+    return activeKernels().kahan(x, n);
+}
+
+float pairwise_sum_simd(const float* x, size_t n) {
+    return pairwiseSum(activeKernels(), x, n);
+}
+
+float dummy_sum(const float* x, size_t n) {
+    return activeKernels().dummy(x, n);
+}
+
+template<>
+float sum<NaiveSum, float>(const float* x, size_t n) {
+    return dummy_sum(x, n);
+}
+
+template<>
+float sum<KahanSum, float>(const float* x, size_t n) {
+    return kahan_sum(x, n);
+}
+
+template<>
+float sum<WideSum, float>(const float* x, size_t n) {
+    return (float) activeKernels().wide(x, n);
 }
 
 void Statistics::update(float x) {
@@ -75,17 +93,51 @@ void Statistics::update(float x) {
     savedCount++;
     savedSum += x;
 
-    float newMean = savedMean + (x - savedMean) / (float) savedCount;
+    double newMean = savedMean + (x - savedMean) / (double) savedCount;
     helperM = helperM + (x - savedMean) * (x - newMean);
 
     savedMean = newMean;
 }
 
+// Chan et al. pairwise update of (count, mean, M2).
+void Statistics::mergeMoments(size_t n, double sum, double mean, double m2, float lo, float hi) {
+    if (n == 0) {
+        return;
+    }
+    if (savedCount == 0) {
+        savedMin = lo;
+        savedMax = hi;
+    } else {
+        savedMin = std::min(savedMin, lo);
+        savedMax = std::max(savedMax, hi);
+    }
+    size_t total = savedCount + n;
+    double delta = mean - savedMean;
+    savedMean += delta * ((double) n / (double) total);
+    helperM += m2 + delta * delta * ((double) savedCount * (double) n / (double) total);
+    savedSum += sum;
+    savedCount = total;
+}
+
+void Statistics::update(const float* x, size_t n) {
+    const size_t block = 4096;
+    auto& kernels = activeKernels();
+    for (size_t begin = 0; begin < n; begin += block) {
+        size_t len = std::min(block, n - begin);
+        BlockMoments m = kernels.moments(x + begin, len);
+        mergeMoments(len, m.sum, m.sum / (double) len, m.m2, m.min, m.max);
+    }
+}
+
+void Statistics::merge(const Statistics& other) {
+    mergeMoments(other.savedCount, other.savedSum, other.savedMean, other.helperM, other.savedMin, other.savedMax);
+}
+
 float Statistics::min() const noexcept {
     return savedMin;
 }
 
-int Statistics::count() const noexcept {
+size_t Statistics::count() const noexcept {
     return savedCount;
 }
 
@@ -94,30 +146,42 @@ float Statistics::max() const noexcept {
 }
 
 float Statistics::sum() const noexcept {
-    return savedSum;
+    return (float) savedSum;
 }
 
 float Statistics::mean() const noexcept {
-    return savedMean;
+    return (float) savedMean;
 }
 
 float Statistics::variance() const noexcept {
-    return helperM / (float) count();
+    return (float) (helperM / (double) count());
 }
 
 
-float length(const float* x, int n) {
-    float sum = 0;
-    float maxLength = 1.f;
-    for (int i = 0; i < n; i++) {
-        float curLen = std::fabs(x[i]);
-        if (curLen > maxLength) {
-            float coef = maxLength / curLen;
-            sum *= coef * coef;
-            maxLength = curLen;
-        }
-        float cur = x[i] / maxLength;
-        sum += cur * cur;
+float length(const float* x, size_t n) {
+    float result;
+    activeKernels().norms(x, 1, n, &result);
+    return result;
+}
+
+void row_lengths(const float* x, size_t rows, size_t cols, float* out) {
+    activeKernels().norms(x, rows, cols, out);
+}
+
+Summary summarize(const float* x, size_t n) {
+    // Blocks stay in L1/L2 between the two moment passes, so DRAM sees every element once.
+    const size_t block = 4096;
+    auto& kernels = activeKernels();
+    FusedLanes lanes = {};
+    Summary result = {};
+    for (size_t begin = 0; begin < n; begin += block) {
+        size_t len = std::min(block, n - begin);
+        BlockMoments m = kernels.fused(x + begin, len, lanes);
+        result.stats.mergeMoments(len, m.sum, m.sum / (double) len, m.m2, m.min, m.max);
     }
-    return maxLength * std::sqrt(sum);
-}
\ No newline at end of file
+    FusedTotals totals = finishFused(lanes);
+    result.dummy = totals.dummy;
+    result.kahan = totals.kahan;
+    result.length = (float) std::sqrt(totals.sumSquares);
+    return result;
+}
@@ -1,6 +1,11 @@
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
-#include <random>
+#include <utility>
+#include "multistart.h"
+#include "newton_lanes.h"
+#include "parallel.h"
+#include "solver.h"
 
 using namespace std;
 
@@ -11,109 +16,48 @@ const double MIN_X = -5;
 const double MAX_X = 5;
 const int MAX_STEPS = 10000;
 
-class RastriginFunction {
-public:
-    static bool differentSign(double a, double b) {
-        return of(a) * of(b) < 0.0;
-    }
+const SolverOptions OPTIONS = {EPS_F_DIFF, EPS_X_DIFF, MAX_STEPS};
+// Bisection here has always stopped on f alone, running to MAX_STEPS once the interval collapses.
+const SolverOptions BISECT_OPTIONS = {EPS_F_DIFF, EPS_X_DIFF, MAX_STEPS, false};
 
-    static double of(double x) {
-        return 10.0 + x * x - 10 * cos(2 * M_PI * x);
-    }
+typedef PointN<1> Point1d;
 
-    static double absOf(double x) {
-        return fabs(of(x));
-    }
+// Starts are drawn per start number from the seed, so the statistics do not depend on the thread count.
+const uint64_t SEED = 0;
 
-    static double getDeriv(double x) {
-        return 2.0 * x + 20 * M_PI * sin(2 * M_PI * x);
-    }
-
-
-    static double deriv_deriv(double x) {
-        return 2 + 40 * M_PI * M_PI * cos(2 * M_PI * x);
-    }
-
-
-    static bool differentSignDeriv(double a, double b) {
-        return getDeriv(a) * getDeriv(b) < 0.0;
-    }
-};
-
-struct Result {
-    double point;
-    int steps;
-};
-
-Result bisect1d(double a, double b, int step) {
-    double mid = a + (b - a) / 2;
-
-    if (step > MAX_STEPS) return {mid, step};
-
-    if (RastriginFunction::absOf(mid) < EPS_F_DIFF) return {mid, step};
-
-    if (RastriginFunction::differentSignDeriv(a, mid)) {
-        return bisect1d(a, mid, step + 1);
-    } else {
-        return bisect1d(mid, b, step + 1);
-    }
-}
-
-Result newton1d(double x, int step) {
-    if (step > MAX_STEPS) return {x, step};
-    double rastr = RastriginFunction::getDeriv(x);
-    double der = RastriginFunction::deriv_deriv(x);
-
-    if (abs(rastr) < EPS_F_DIFF) return {x, step};
-    if (abs(der) < EPS_F_DIFF) return {x, step};
-    double xNew = x - rastr / der;
-    if (abs(xNew - x) < EPS_X_DIFF) return {x, step};
-    return newton1d(xNew, step + 1);
+void printStat(const char *method, const MultistartStats<Point1d> &stats) {
+    cout << method << ": "
+         << stats.averageSteps()
+         << " avg. steps, " << stats.maxSteps << " max, hit rate " << stats.hitRate()
+         << ", best f(" << stats.best[0] << ") = " << stats.bestValue << endl;
 }
 
-class Randomer {
-    std::mt19937 gen;
-    std::uniform_real_distribution<double> dis;
-public:
-    explicit Randomer() : gen(0), dis(MIN_X, MAX_X) {
-    }
-
-    double get() {
-        return dis(gen);
-    }
-};
-
-void printBisectStat(Randomer &randomer, int tries) {
-    int bisectSteps = 0;
-    for (int i = 0; i < tries; ++i) {
-        auto x1 = randomer.get();
-        auto x2 = randomer.get();
+void printBisectStat(ThreadPool &pool, size_t tries) {
+    auto stats = multistart(pool, tries, SEED, [](CounterRng &rng) {
+        auto x1 = rng.uniform(MIN_X, MAX_X);
+        auto x2 = rng.uniform(MIN_X, MAX_X);
         if (x2 > x1)
             swap(x1, x2);
-        auto [m, step] = bisect1d(x1, x2, 0);
-        bisectSteps += step;
-    }
-
-    cout << "Bisect method: "
-         << (double) bisectSteps / tries
-         << " avg. steps" << endl;
+        return make_pair(Point1d{{x1}}, Point1d{{x2}});
+    }, [](pair<Point1d, Point1d> bounds) {
+        return bisect<Rastrigin>(bounds.first, bounds.second, BISECT_OPTIONS);
+    }, Rastrigin::absOf<1>, EPS_F_DIFF);
+    printStat("Bisect method", stats);
 }
 
-void printNewtonStat(Randomer &randomer, int tries) {
-    int newtonSteps = 0;
-    for (int i = 0; i < tries; ++i) {
-        double x = randomer.get();
-        auto [m, step] = newton1d(x, 0);
-        newtonSteps += step;
-    }
-    cout << "Newton method: "
-         << (double) newtonSteps / tries
-         << " avg. steps" << endl;
+void printNewtonStat(ThreadPool &pool, size_t tries) {
+    auto stats = multistartBlocks<Point1d>(pool, tries, SEED, [](CounterRng &rng) {
+        return Point1d{{rng.uniform(MIN_X, MAX_X)}};
+    }, [](size_t first, size_t last, auto &&start, auto &&finish) {
+        newtonLanes<Rastrigin, 1>(first, last, start, finish, OPTIONS);
+    }, Rastrigin::absOf<1>, EPS_F_DIFF);
+    printStat("Newton method", stats);
 }
 
-int main() {
-    Randomer randomer;
-    int n_tries = 30;
-    printBisectStat(randomer, n_tries);
-    printNewtonStat(randomer, n_tries);
-}
\ No newline at end of file
+// 1d-optimize [tries [threads]]
+int main(int argc, char **argv) {
+    size_t n_tries = argc > 1 ? strtoull(argv[1], nullptr, 10) : 30;
+    ThreadPool pool(argc > 2 ? (unsigned) strtoul(argv[2], nullptr, 10) : thread::hardware_concurrency());
+    printBisectStat(pool, n_tries);
+    printNewtonStat(pool, n_tries);
+}
@@ -0,0 +1,99 @@
+#ifndef HW3_ARRAY_H
+#define HW3_ARRAY_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Неизменяемый массив, который либо владеет своими данными, либо смотрит в чужую память,
+// например в отображённый файл скомпилированного бака. Читающий код разницы не видит.
+template<class T>
+class Array {
+public:
+    Array() = default;
+
+    Array(std::vector<T> values) : owned(std::move(values)), pointer(owned.data()), count(owned.size()) {
+    }
+
+    // The memory must outlive the array and every copy of it.
+    static Array view(const T *data, size_t size) {
+        Array array;
+        array.viewing = true;
+        array.pointer = data;
+        array.count = size;
+        return array;
+    }
+
+    Array(const Array &other) : owned(other.owned), viewing(other.viewing), count(other.count) {
+        pointer = viewing ? other.pointer : owned.data();
+    }
+
+    Array(Array &&other) noexcept: owned(std::move(other.owned)), viewing(other.viewing), count(other.count) {
+        pointer = viewing ? other.pointer : owned.data();
+        other.pointer = nullptr;
+        other.count = 0;
+    }
+
+    Array &operator=(Array other) noexcept {
+        owned = std::move(other.owned);
+        viewing = other.viewing;
+        count = other.count;
+        pointer = viewing ? other.pointer : owned.data();
+        return *this;
+    }
+
+    // Hands the owned values back, e.g. to be refilled without reallocating, and leaves the array empty.
+    // A view has nothing to give and returns an empty vector.
+    std::vector<T> release() {
+        std::vector<T> values = viewing ? std::vector<T>() : std::move(owned);
+        owned.clear();
+        viewing = false;
+        pointer = nullptr;
+        count = 0;
+        return values;
+    }
+
+    bool isView() const noexcept {
+        return viewing;
+    }
+
+    size_t size() const noexcept {
+        return count;
+    }
+
+    bool empty() const noexcept {
+        return count == 0;
+    }
+
+    const T *data() const noexcept {
+        return pointer;
+    }
+
+    const T &operator[](size_t i) const {
+        return pointer[i];
+    }
+
+    const T *begin() const noexcept {
+        return pointer;
+    }
+
+    const T *end() const noexcept {
+        return pointer + count;
+    }
+
+    const T &front() const {
+        return pointer[0];
+    }
+
+    const T &back() const {
+        return pointer[count - 1];
+    }
+
+private:
+    std::vector<T> owned;
+    bool viewing = false;
+    const T *pointer = nullptr;
+    size_t count = 0;
+};
+
+#endif //HW3_ARRAY_H
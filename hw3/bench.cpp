@@ -0,0 +1,335 @@
+// Замеры скорости и точности запросов к баку на синтетических сетках: сфера, цилиндр, капсула.
+// Вывод -- JSON, по записи на форму/размер/запрос.
+//   tank_bench [maxTriangles]
+//
+// Все три формы -- тела вращения: ломаный профиль (r, z), повёрнутый правильным n-угольником.
+// Сечение такой сетки на высоте z -- правильный n-угольник с радиусом r(z), линейным между
+// узлами профиля, так что точный объём сетки под уровнем считается в замкнутом виде. Ошибка
+// запросов меряется относительно него; отдельно -- отличие от гладкого тела (ошибка разбиения).
+// Запросы по кривой объёма точны для сетки, и если их ошибка выше CURVE_TOLERANCE, код выхода 1.
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include "tank.h"
+
+namespace {
+
+    const double RADIUS = 10;
+    const size_t QUERIES = 1000;
+    // The volume curve is exact for the mesh: anything above rounding noise is a bug, not a trade-off.
+    const double CURVE_TOLERANCE = 1e-12;
+
+    struct Shape {
+        std::string name;
+        // Profile from the bottom pole to the top one: z never decreases, r is 0 at both ends.
+        std::vector<double> r, z;
+        size_t segments;
+        // Volume of the smooth body below the level.
+        std::function<double(double)> smooth;
+
+        // Cross-section of the mesh is k r^2.
+        double k() const {
+            return segments / 2.0 * std::sin(2 * M_PI / (double) segments);
+        }
+
+        // Exact volume of the mesh below the level.
+        double volume(double level) const {
+            double sum = 0;
+            for (size_t i = 0; i + 1 < z.size() && z[i] < level; i++) {
+                double height = z[i + 1] - z[i];
+                if (height <= 0) {
+                    continue;
+                }
+                double t = std::min(level, z[i + 1]) - z[i];
+                double slope = (r[i + 1] - r[i]) / height;
+                sum += k() * (r[i] * r[i] * t + r[i] * slope * t * t + slope * slope * t * t * t / 3);
+            }
+            return sum;
+        }
+
+        // Exact level of the mesh for the volume.
+        double level(double volume) const {
+            double lower = z.front(), upper = z.back();
+            for (int i = 0; i < 200 && lower < upper; i++) {
+                double middle = (lower + upper) / 2;
+                if (middle == lower || middle == upper) {
+                    break;
+                }
+                (this->volume(middle) < volume ? lower : upper) = middle;
+            }
+            return (lower + upper) / 2;
+        }
+
+        std::vector<double> triangles() const {
+            std::vector<double> coords;
+            auto point = [&](size_t i, size_t j) {
+                double angle = 2 * M_PI * (double) (j % segments) / (double) segments;
+                coords.push_back(r[i] * std::cos(angle));
+                coords.push_back(r[i] * std::sin(angle));
+                coords.push_back(z[i]);
+            };
+            // Quads (a, b, c, d) go counter-clockwise seen from outside; at the poles one of the pair degenerates.
+            for (size_t i = 0; i + 1 < z.size(); i++) {
+                for (size_t j = 0; j < segments; j++) {
+                    if (r[i] != 0) {
+                        point(i, j);
+                        point(i, j + 1);
+                        point(i + 1, j + 1);
+                    }
+                    if (r[i + 1] != 0) {
+                        point(i, j);
+                        point(i + 1, j + 1);
+                        point(i + 1, j);
+                    }
+                }
+            }
+            return coords;
+        }
+    };
+
+    // segments around, bands from pole to pole: 2 segments (bands - 1) triangles.
+    Shape sphere(size_t triangles) {
+        size_t bands = std::max<size_t>(3, (size_t) std::sqrt((double) triangles / 4));
+        Shape shape = {"sphere", {}, {}, 2 * bands, [](double level) {
+            double t = std::clamp(level + RADIUS, 0.0, 2 * RADIUS);
+            return M_PI * t * t * (3 * RADIUS - t) / 3;
+        }};
+        for (size_t i = 0; i <= bands; i++) {
+            double angle = M_PI * (double) i / (double) bands;
+            shape.r.push_back(i == 0 || i == bands ? 0 : RADIUS * std::sin(angle));
+            shape.z.push_back(-RADIUS * std::cos(angle));
+        }
+        return shape;
+    }
+
+    // Height 4 R; flat caps are fans, the wall is cut into stacks so that faces start at many heights.
+    Shape cylinder(size_t triangles) {
+        size_t stacks = std::max<size_t>(1, (size_t) std::sqrt((double) triangles / 8));
+        size_t segments = std::max<size_t>(3, triangles / (2 * stacks + 2));
+        Shape shape = {"cylinder", {0}, {0}, segments, [](double level) {
+            return M_PI * RADIUS * RADIUS * std::clamp(level, 0.0, 4 * RADIUS);
+        }};
+        for (size_t i = 0; i <= stacks; i++) {
+            shape.r.push_back(RADIUS);
+            shape.z.push_back(4 * RADIUS * (double) i / (double) stacks);
+        }
+        shape.r.push_back(0);
+        shape.z.push_back(4 * RADIUS);
+        return shape;
+    }
+
+    // A cylinder of length 2 R between two hemispheres.
+    Shape capsule(size_t triangles) {
+        size_t bands = std::max<size_t>(2, (size_t) std::sqrt((double) triangles / 8));
+        size_t stacks = bands;
+        Shape shape = {"capsule", {}, {}, 2 * bands, [](double level) {
+            auto cap = [](double t) {
+                t = std::clamp(t, 0.0, RADIUS);
+                return M_PI * t * t * (3 * RADIUS - t) / 3;
+            };
+            double wall = M_PI * RADIUS * RADIUS * std::clamp(level - RADIUS, 0.0, 2 * RADIUS);
+            double top = 2 * M_PI * RADIUS * RADIUS * RADIUS / 3 - cap(4 * RADIUS - level);
+            return cap(level) + wall + (level > 3 * RADIUS ? top : 0);
+        }};
+        for (size_t i = 0; i <= bands; i++) {
+            double angle = M_PI / 2 * (double) i / (double) bands;
+            shape.r.push_back(i == 0 ? 0 : RADIUS * std::sin(angle));
+            shape.z.push_back(RADIUS - RADIUS * std::cos(angle));
+        }
+        for (size_t i = 1; i <= stacks; i++) {
+            shape.r.push_back(RADIUS);
+            shape.z.push_back(RADIUS + 2 * RADIUS * (double) i / (double) stacks);
+        }
+        for (size_t i = 1; i <= bands; i++) {
+            double angle = M_PI / 2 + M_PI / 2 * (double) i / (double) bands;
+            shape.r.push_back(i == bands ? 0 : RADIUS * std::sin(angle));
+            shape.z.push_back(3 * RADIUS - RADIUS * std::cos(angle));
+        }
+        return shape;
+    }
+
+    // Text with round-trip precision, so the loaded mesh is exactly the generated one.
+    void writeStl(const std::string &path, const std::vector<double> &coords) {
+        std::FILE *out = std::fopen(path.c_str(), "w");
+        if (out == nullptr) {
+            throw std::runtime_error(path + ": " + std::strerror(errno));
+        }
+        std::fprintf(out, "solid tank_bench\n");
+        for (size_t i = 0; i + 9 <= coords.size(); i += 9) {
+            std::fprintf(out, "facet normal 0 0 0\nouter loop\n");
+            for (int k = 0; k < 9; k += 3) {
+                std::fprintf(out, "vertex %.17g %.17g %.17g\n", coords[i + k], coords[i + k + 1], coords[i + k + 2]);
+            }
+            std::fprintf(out, "endloop\nendfacet\n");
+        }
+        std::fprintf(out, "endsolid tank_bench\n");
+        if (std::fclose(out) != 0) {
+            throw std::runtime_error(path + ": write failed");
+        }
+    }
+
+    double seconds(const std::function<void()> &run) {
+        using clock = std::chrono::steady_clock;
+        auto start = clock::now();
+        run();
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    // Best of several runs, at least 3 and at least ~20 ms of work in total.
+    double bestSeconds(const std::function<void()> &run) {
+        double best = std::numeric_limits<double>::infinity();
+        double spent = 0;
+        for (int i = 0; i < 3 || (spent < 0.02 && i < 1000); i++) {
+            double time = seconds(run);
+            best = std::min(best, time);
+            spent += time;
+        }
+        return best;
+    }
+
+    struct Errors {
+        double mesh = 0;   // against the exact volume or level of the mesh
+        double shape = 0;  // against the smooth body
+
+        void add(double got, double exact, double smooth, double scale) {
+            mesh = std::max(mesh, std::fabs(got - exact) / scale);
+            shape = std::max(shape, std::fabs(got - smooth) / scale);
+        }
+    };
+
+    bool first = true;
+    bool failed = false;
+
+    // Fails the run when a query backed by the volume curve is off the exact mesh by more than rounding.
+    void checkCurve(const Shape &shape, size_t triangles, const char *query, const Errors &errors) {
+        if (errors.mesh > CURVE_TOLERANCE) {
+            std::fprintf(stderr, "%s, %zu triangles, %s: relative error %.3g above %.3g\n", shape.name.c_str(),
+                         triangles, query, errors.mesh, CURVE_TOLERANCE);
+            failed = true;
+        }
+    }
+
+    void report(const Shape &shape, size_t triangles, const char *query, const char *path, double secondsEach,
+                const Errors &errors) {
+        std::printf("%s\n    {\"shape\": \"%s\", \"triangles\": %zu, \"query\": \"%s\", \"path\": \"%s\", "
+                    "\"us_per_query\": %.4f, \"queries_per_s\": %.1f, \"max_rel_error\": %.3g, "
+                    "\"max_rel_shape_error\": %.3g}",
+                    first ? "" : ",", shape.name.c_str(), triangles, query, path, secondsEach * 1e6,
+                    1 / secondsEach, errors.mesh, errors.shape);
+        first = false;
+    }
+
+    void bench(const Shape &shape, const std::string &path) {
+        std::vector<double> coords = shape.triangles();
+        size_t triangles = coords.size() / 9;
+        writeStl(path, coords);
+        coords = {};
+
+        Tank tank;
+        double load = seconds([&] { tank.read(path); });
+        std::printf("%s\n    {\"shape\": \"%s\", \"triangles\": %zu, \"query\": \"load\", \"path\": \"stl\", "
+                    "\"ms\": %.3f, \"vertices\": %zu}",
+                    first ? "" : ",", shape.name.c_str(), triangles, load * 1e3, tank.mesh.vertices());
+        first = false;
+
+        double bottom = shape.z.front(), top = shape.z.back();
+        double total = shape.volume(top);
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<double> unit(0, 1);
+        std::vector<double> levels(QUERIES), volumes(QUERIES);
+        for (size_t i = 0; i < QUERIES; i++) {
+            levels[i] = bottom + (top - bottom) * unit(gen);
+            volumes[i] = total * unit(gen);
+        }
+        std::vector<double> exactVolumes(QUERIES), exactLevels(QUERIES);
+        for (size_t i = 0; i < QUERIES; i++) {
+            exactVolumes[i] = shape.volume(levels[i]);
+            exactLevels[i] = shape.level(volumes[i]);
+        }
+
+        std::vector<double> got(QUERIES);
+        auto volumeQuery = [&](const char *name, const std::function<double(double)> &query) {
+            double time = bestSeconds([&] {
+                for (size_t i = 0; i < QUERIES; i++) {
+                    got[i] = query(levels[i]);
+                }
+            });
+            Errors errors;
+            for (size_t i = 0; i < QUERIES; i++) {
+                errors.add(got[i], exactVolumes[i], shape.smooth(levels[i]), total);
+            }
+            report(shape, triangles, "volume-at-level", name, time / QUERIES, errors);
+            if (std::strcmp(name, "curve") == 0) {
+                checkCurve(shape, triangles, "volume-at-level", errors);
+            }
+        };
+        auto levelQuery = [&](const char *name, const std::function<double(double)> &query) {
+            double time = bestSeconds([&] {
+                for (size_t i = 0; i < QUERIES; i++) {
+                    got[i] = query(volumes[i]);
+                }
+            });
+            Errors errors;
+            for (size_t i = 0; i < QUERIES; i++) {
+                // The smooth body's level is not in closed form: its volume at the found level is compared instead.
+                errors.mesh = std::max(errors.mesh, std::fabs(got[i] - exactLevels[i]) / (top - bottom));
+                errors.shape = std::max(errors.shape, std::fabs(shape.smooth(got[i]) - volumes[i]) / total);
+            }
+            report(shape, triangles, "level-by-volume", name, time / QUERIES, errors);
+            // With the split the level comes from the curve.
+            if (std::strcmp(name, "split") == 0) {
+                checkCurve(shape, triangles, "level-by-volume", errors);
+            }
+        };
+
+        volumeQuery("split", [&](double level) { return tank.getVolumeByLevelWithSplit(level); });
+        volumeQuery("no-split", [&](double level) { return tank.getVolumeByLevelNoSplit(level); });
+        volumeQuery("curve", [&](double level) { return tank.curve.volume(level); });
+        levelQuery("split", [&](double volume) { return tank.getLevelByVolume(volume, true); });
+        levelQuery("no-split", [&](double volume) { return tank.getLevelByVolume(volume, false); });
+
+        {
+            double time = bestSeconds([&] { got = tank.getVolumesByLevels(levels); });
+            Errors errors;
+            for (size_t i = 0; i < QUERIES; i++) {
+                errors.add(got[i], exactVolumes[i], shape.smooth(levels[i]), total);
+            }
+            report(shape, triangles, "batch-volume-at-level", "split", time / QUERIES, errors);
+            checkCurve(shape, triangles, "batch-volume-at-level", errors);
+        }
+        {
+            double time = bestSeconds([&] { got = tank.getLevelsByVolumes(volumes); });
+            Errors errors;
+            for (size_t i = 0; i < QUERIES; i++) {
+                errors.mesh = std::max(errors.mesh, std::fabs(got[i] - exactLevels[i]) / (top - bottom));
+                errors.shape = std::max(errors.shape, std::fabs(shape.smooth(got[i]) - volumes[i]) / total);
+            }
+            report(shape, triangles, "batch-level-by-volume", "split", time / QUERIES, errors);
+            checkCurve(shape, triangles, "batch-level-by-volume", errors);
+        }
+        std::remove(path.c_str());
+    }
+
+}
+
+int main(int argc, char **argv) {
+    size_t maxTriangles = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : size_t(1) << 20;
+    const std::string path = "tank_bench.stl";
+    std::printf("{\n  \"queries\": %zu,\n  \"results\": [", QUERIES);
+    for (size_t n = 1000; n <= maxTriangles; n *= 10) {
+        for (auto make: {sphere, cylinder, capsule}) {
+            bench(make(n), path);
+        }
+    }
+    std::printf("\n  ]\n}\n");
+    return failed ? 1 : 0;
+}
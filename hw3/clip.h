@@ -0,0 +1,310 @@
+#ifndef HW3_CLIP_H
+#define HW3_CLIP_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <immintrin.h>
+#include <vector>
+#include "mesh.h"
+#include "parallel.h"
+
+// Объём под плоскостью z = level, посчитанный срезанием треугольников прямо в регистрах.
+//
+// Одинокая вершина l -- та, что одна по свою сторону плоскости; e1 и e2 идут за ней по обходу,
+// p и q -- точки пересечения рёбер l-e1 и l-e2 с плоскостью. С вершиной конуса (0, 0, level) на
+// плоскости тетраэдр на (l, p, q) равен l_z (p_x q_y - p_y q_x) / 6, где высоты отсчитаны от уровня.
+// Мокрая часть -- этот треугольник, если l под водой, и остаток треугольника, если l над водой.
+// Ни ветвлений по случаям, ни выделений памяти, ни исключений.
+//
+// Заодно считается вклад в площадь сечения A(h) = dV/dh: отрезок pq -- кусок контура зеркала,
+// и по формуле Грина он добавляет (q x p)_z / 2, если l под водой, и (p x q)_z / 2, если над.
+
+namespace clip {
+
+    struct Wet {
+        double volume;
+        double area;
+    };
+
+    // Signed volume of the cone from (0, 0, level) over the part of abc at or below the level,
+    // and the face's share of the cross-section area at the level.
+    inline Wet cut(double ax, double ay, double az, double bx, double by, double bz,
+                   double cx, double cy, double cz, double level) {
+        az -= level;
+        bz -= level;
+        cz -= level;
+        bool ba = az <= 0, bb = bz <= 0, bc = cz <= 0;
+        double full = ax * (by * cz - bz * cy) + ay * (bz * cx - bx * cz) + az * (bx * cy - by * cx);
+        bool loneA = ba != bb && ba != bc;
+        bool loneB = bb != ba && bb != bc;
+        double lx = loneA ? ax : loneB ? bx : cx, ly = loneA ? ay : loneB ? by : cy, lz = loneA ? az : loneB ? bz : cz;
+        double e1x = loneA ? bx : loneB ? cx : ax, e1y = loneA ? by : loneB ? cy : ay, e1z = loneA ? bz : loneB ? cz : az;
+        double e2x = loneA ? cx : loneB ? ax : bx, e2y = loneA ? cy : loneB ? ay : by, e2z = loneA ? cz : loneB ? az : bz;
+        // p = l + (e1 - l) t1 and q = l + (e2 - l) t2 with t = -l_z / (e_z - l_z); expanding the cross product
+        // leaves a single division. Without a lone vertex the denominator may vanish, the result is masked then.
+        double ux = e1x - lx, uy = e1y - ly, wx = e2x - lx, wy = e2y - ly;
+        double d1 = e1z - lz, d2 = e2z - lz;
+        double den = d1 * d2;
+        double cross = lz * (lz * (ux * wy - uy * wx) - d2 * (ux * ly - uy * lx) - d1 * (lx * wy - ly * wx));
+        // cross / den is (p x q)_z.
+        double pq = cross / (den == 0 ? 1 : den);
+        double cone = lz * pq;
+        int below = ba + bb + bc;
+        double wet = below == 3 ? full : below == 1 ? cone : below == 2 ? full - cone : 0.0;
+        double area = below == 1 ? -pq : below == 2 ? pq : 0.0;
+        return {wet / 6.0, area / 2.0};
+    }
+
+    struct Liquid {
+        double volume;
+        double moment[3];    // first moments of the liquid about the origin
+        double wettedArea;   // wall under the liquid
+        double surfaceArea;  // free surface
+
+        void add(const Liquid &other) {
+            volume += other.volume;
+            for (int k = 0; k < 3; k++) {
+                moment[k] += other.moment[k];
+            }
+            wettedArea += other.wettedArea;
+            surfaceArea += other.surfaceArea;
+        }
+    };
+
+    // Everything about the part of abc at or below the level from one clip. The cone over a piece has its
+    // centroid at the mean of its four vertices, the apex being one of them, so the first moments follow
+    // from the same volumes. p - l and q - l are e1 - l and e2 - l scaled by t1 and t2, so the lone
+    // vertex's corner has t1 t2 of the face's area. The free-surface share is the one from cut().
+    inline Liquid integrate(double ax, double ay, double az, double bx, double by, double bz,
+                            double cx, double cy, double cz, double level) {
+        az -= level;
+        bz -= level;
+        cz -= level;
+        bool ba = az <= 0, bb = bz <= 0, bc = cz <= 0;
+        double full = ax * (by * cz - bz * cy) + ay * (bz * cx - bx * cz) + az * (bx * cy - by * cx);
+        double nx = (by - ay) * (cz - az) - (bz - az) * (cy - ay);
+        double ny = (bz - az) * (cx - ax) - (bx - ax) * (cz - az);
+        double nz = (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+        double fullArea = std::sqrt(nx * nx + ny * ny + nz * nz);
+        bool loneA = ba != bb && ba != bc;
+        bool loneB = bb != ba && bb != bc;
+        double lx = loneA ? ax : loneB ? bx : cx, ly = loneA ? ay : loneB ? by : cy, lz = loneA ? az : loneB ? bz : cz;
+        double e1x = loneA ? bx : loneB ? cx : ax, e1y = loneA ? by : loneB ? cy : ay, e1z = loneA ? bz : loneB ? cz : az;
+        double e2x = loneA ? cx : loneB ? ax : bx, e2y = loneA ? cy : loneB ? ay : by, e2z = loneA ? cz : loneB ? az : bz;
+        double d1 = e1z - lz, d2 = e2z - lz;
+        double den = d1 * d2;
+        double r = lz / (den == 0 ? 1 : den);
+        double t1 = -r * d2, t2 = -r * d1;
+        double px = lx + (e1x - lx) * t1, py = ly + (e1y - ly) * t1;
+        double qx = lx + (e2x - lx) * t2, qy = ly + (e2y - ly) * t2;
+        double pq = px * qy - py * qx;
+        double cone = lz * pq;
+        double coneArea = t1 * t2 * fullArea;
+
+        int below = ba + bb + bc;
+        // Weights of the whole face and of the lone vertex's corner in the wet part.
+        double wFull = below >= 2 ? 1.0 : 0.0;
+        double wCone = below == 1 ? 1.0 : below == 2 ? -1.0 : 0.0;
+        double volume = wFull * full + wCone * cone;
+        double mx = wFull * full * (ax + bx + cx) + wCone * cone * (lx + px + qx);
+        double my = wFull * full * (ay + by + cy) + wCone * cone * (ly + py + qy);
+        double mz = wFull * full * (az + bz + cz) + wCone * cone * lz;
+        return {volume / 6.0, {mx / 24.0, my / 24.0, mz / 24.0 + level * volume / 6.0},
+                (wFull * fullArea + wCone * coneArea) / 2.0, -wCone * pq / 2.0};
+    }
+
+    inline double volume(double ax, double ay, double az, double bx, double by, double bz,
+                         double cx, double cy, double cz, double level) {
+        return cut(ax, ay, az, bx, by, bz, cx, cy, cz, level).volume;
+    }
+
+    inline Wet scalarRange(const Mesh &mesh, size_t first, size_t last, double level) {
+        const double *x = mesh.x.data(), *y = mesh.y.data(), *z = mesh.z.data();
+        const uint32_t *index = mesh.index.data();
+        Wet sum = {0, 0};
+        for (size_t i = first; i < last; i++) {
+            const uint32_t *v = index + i * 3;
+            Wet wet = cut(x[v[0]], y[v[0]], z[v[0]], x[v[1]], y[v[1]], z[v[1]], x[v[2]], y[v[2]], z[v[2]], level);
+            sum.volume += wet.volume;
+            sum.area += wet.area;
+        }
+        return sum;
+    }
+
+    // blendv takes the second operand where the mask is set: a if first, else b if second, else c.
+    __attribute__((target("avx2,fma")))
+    inline __m256d pick(__m256d a, __m256d b, __m256d c, __m256d first, __m256d second) {
+        return _mm256_blendv_pd(_mm256_blendv_pd(c, b, second), a, first);
+    }
+
+    // Four triangles per iteration; lanes are selected with masks instead of the ternaries above.
+    __attribute__((target("avx2,fma")))
+    inline Wet avx2Range(const Mesh &mesh, size_t first, size_t last, double level) {
+        const double *x = mesh.x.data(), *y = mesh.y.data(), *z = mesh.z.data();
+        const uint32_t *index = mesh.index.data();
+        const __m256d h = _mm256_set1_pd(level);
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d one = _mm256_set1_pd(1.0);
+        __m256d sum = zero;
+        __m256d area = zero;
+        size_t i = first;
+        for (; i + 4 <= last; i += 4) {
+            const int *t = reinterpret_cast<const int *>(index + i * 3);
+            __m128i ia = _mm_setr_epi32(t[0], t[3], t[6], t[9]);
+            __m128i ib = _mm_setr_epi32(t[1], t[4], t[7], t[10]);
+            __m128i ic = _mm_setr_epi32(t[2], t[5], t[8], t[11]);
+            __m256d az = _mm256_sub_pd(_mm256_i32gather_pd(z, ia, 8), h);
+            __m256d bz = _mm256_sub_pd(_mm256_i32gather_pd(z, ib, 8), h);
+            __m256d cz = _mm256_sub_pd(_mm256_i32gather_pd(z, ic, 8), h);
+            __m256d ba = _mm256_cmp_pd(az, zero, _CMP_LE_OQ);
+            __m256d bb = _mm256_cmp_pd(bz, zero, _CMP_LE_OQ);
+            __m256d bc = _mm256_cmp_pd(cz, zero, _CMP_LE_OQ);
+            // Neighbouring faces of an STL are usually neighbours in space: skip the x and y gathers
+            // when all four are dry.
+            if (_mm256_movemask_pd(_mm256_or_pd(ba, _mm256_or_pd(bb, bc))) == 0) {
+                continue;
+            }
+            __m256d ax = _mm256_i32gather_pd(x, ia, 8), ay = _mm256_i32gather_pd(y, ia, 8);
+            __m256d bx = _mm256_i32gather_pd(x, ib, 8), by = _mm256_i32gather_pd(y, ib, 8);
+            __m256d cx = _mm256_i32gather_pd(x, ic, 8), cy = _mm256_i32gather_pd(y, ic, 8);
+
+            __m256d full = _mm256_mul_pd(az, _mm256_fmsub_pd(bx, cy, _mm256_mul_pd(by, cx)));
+            full = _mm256_fmadd_pd(ay, _mm256_fmsub_pd(bz, cx, _mm256_mul_pd(bx, cz)), full);
+            full = _mm256_fmadd_pd(ax, _mm256_fmsub_pd(by, cz, _mm256_mul_pd(bz, cy)), full);
+
+            __m256d abDiffer = _mm256_xor_pd(ba, bb);
+            __m256d loneA = _mm256_and_pd(abDiffer, _mm256_xor_pd(ba, bc));
+            __m256d loneB = _mm256_and_pd(abDiffer, _mm256_xor_pd(bb, bc));
+            __m256d lone = _mm256_or_pd(abDiffer, _mm256_xor_pd(ba, bc));
+            __m256d lx = pick(ax, bx, cx, loneA, loneB), ly = pick(ay, by, cy, loneA, loneB);
+            __m256d lz = pick(az, bz, cz, loneA, loneB);
+            __m256d e1x = pick(bx, cx, ax, loneA, loneB), e1y = pick(by, cy, ay, loneA, loneB);
+            __m256d e1z = pick(bz, cz, az, loneA, loneB);
+            __m256d e2x = pick(cx, ax, bx, loneA, loneB), e2y = pick(cy, ay, by, loneA, loneB);
+            __m256d e2z = pick(cz, az, bz, loneA, loneB);
+            __m256d ux = _mm256_sub_pd(e1x, lx), uy = _mm256_sub_pd(e1y, ly);
+            __m256d wx = _mm256_sub_pd(e2x, lx), wy = _mm256_sub_pd(e2y, ly);
+            __m256d d1 = _mm256_sub_pd(e1z, lz), d2 = _mm256_sub_pd(e2z, lz);
+            __m256d den = _mm256_mul_pd(d1, d2);
+            den = _mm256_blendv_pd(den, one, _mm256_cmp_pd(den, zero, _CMP_EQ_OQ));
+            __m256d uw = _mm256_fmsub_pd(ux, wy, _mm256_mul_pd(uy, wx));
+            __m256d ul = _mm256_fmsub_pd(ux, ly, _mm256_mul_pd(uy, lx));
+            __m256d lw = _mm256_fmsub_pd(lx, wy, _mm256_mul_pd(ly, wx));
+            __m256d cross = _mm256_fmsub_pd(lz, uw, _mm256_fmadd_pd(d2, ul, _mm256_mul_pd(d1, lw)));
+            __m256d pq = _mm256_div_pd(_mm256_mul_pd(lz, cross), den);
+            __m256d cone = _mm256_mul_pd(lz, pq);
+
+            __m256d all = _mm256_and_pd(ba, _mm256_and_pd(bb, bc));
+            __m256d loneBelow = _mm256_cmp_pd(lz, zero, _CMP_LE_OQ);
+            __m256d cut = _mm256_blendv_pd(_mm256_sub_pd(full, cone), cone, loneBelow);
+            sum = _mm256_add_pd(sum, _mm256_and_pd(all, full));
+            sum = _mm256_add_pd(sum, _mm256_and_pd(lone, cut));
+            __m256d section = _mm256_blendv_pd(pq, _mm256_sub_pd(zero, pq), loneBelow);
+            area = _mm256_add_pd(area, _mm256_and_pd(lone, section));
+        }
+        alignas(32) double lanes[4], areas[4];
+        _mm256_store_pd(lanes, sum);
+        _mm256_store_pd(areas, area);
+        Wet tail = scalarRange(mesh, i, last, level);
+        return {(lanes[0] + lanes[1]) / 6.0 + (lanes[2] + lanes[3]) / 6.0 + tail.volume,
+                (areas[0] + areas[1]) / 2.0 + (areas[2] + areas[3]) / 2.0 + tail.area};
+    }
+
+    inline Liquid liquidRange(const Mesh &mesh, size_t first, size_t last, double level) {
+        const double *x = mesh.x.data(), *y = mesh.y.data(), *z = mesh.z.data();
+        const uint32_t *index = mesh.index.data();
+        Liquid sum = {0, {0, 0, 0}, 0, 0};
+        for (size_t i = first; i < last; i++) {
+            const uint32_t *v = index + i * 3;
+            sum.add(integrate(x[v[0]], y[v[0]], z[v[0]], x[v[1]], y[v[1]], z[v[1]], x[v[2]], y[v[2]], z[v[2]],
+                              level));
+        }
+        return sum;
+    }
+
+    typedef Wet (*RangeKernel)(const Mesh &, size_t, size_t, double);
+
+    inline RangeKernel activeRange() {
+        static const RangeKernel kernel = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") ?
+                                          avx2Range : scalarRange;
+        return kernel;
+    }
+
+}
+
+// Triangles are cut into chunks of SCAN_CHUNK independently of the thread count and the chunk
+// results are added in chunk order, so the volume is bitwise the same on any number of threads.
+const size_t SCAN_CHUNK = 1 << 14;
+
+class VolumeScanner {
+public:
+    explicit VolumeScanner(unsigned threads = std::thread::hardware_concurrency())
+            : pool(threads == 0 ? 1 : threads) {
+    }
+
+    unsigned threads() const noexcept {
+        return pool.size();
+    }
+
+    // Signed volume under the level over the whole mesh.
+    double volume(const Mesh &mesh, double level) {
+        return wet(mesh, level).volume;
+    }
+
+    // Signed volume and cross-section area in the same pass.
+    clip::Wet wet(const Mesh &mesh, double level) {
+        check(mesh);
+        size_t triangles = mesh.triangles();
+        size_t chunks = (triangles + SCAN_CHUNK - 1) / SCAN_CHUNK;
+        clip::RangeKernel kernel = clip::activeRange();
+        partial.assign(chunks, {0, 0});
+        pool.run(chunks, [&](size_t chunk) {
+            size_t first = chunk * SCAN_CHUNK;
+            partial[chunk] = kernel(mesh, first, std::min(first + SCAN_CHUNK, triangles), level);
+        });
+        clip::Wet sum = {0, 0};
+        for (auto value: partial) {
+            sum.volume += value.volume;
+            sum.area += value.area;
+        }
+        return sum;
+    }
+
+    // Volume, first moments, wetted and free-surface areas in one pass.
+    clip::Liquid liquid(const Mesh &mesh, double level) {
+        check(mesh);
+        size_t triangles = mesh.triangles();
+        size_t chunks = (triangles + SCAN_CHUNK - 1) / SCAN_CHUNK;
+        liquidPartial.assign(chunks, {0, {0, 0, 0}, 0, 0});
+        pool.run(chunks, [&](size_t chunk) {
+            size_t first = chunk * SCAN_CHUNK;
+            liquidPartial[chunk] = clip::liquidRange(mesh, first, std::min(first + SCAN_CHUNK, triangles), level);
+        });
+        clip::Liquid sum = {0, {0, 0, 0}, 0, 0};
+        for (const auto &value: liquidPartial) {
+            sum.add(value);
+        }
+        return sum;
+    }
+
+private:
+    ThreadPool pool;
+    std::vector<clip::Wet> partial;
+    std::vector<clip::Liquid> liquidPartial;
+    const uint32_t *checkedIndex = nullptr;
+    size_t checkedSize = 0;
+
+    // A mapped index is not checked when it is opened; the kernels gather through it unguarded, so it is
+    // checked here, before the workers start, once for as long as the scanner keeps seeing the same one.
+    void check(const Mesh &mesh) {
+        if (!mesh.index.isView() || (mesh.index.data() == checkedIndex && mesh.index.size() == checkedSize)) {
+            return;
+        }
+        mesh.checkIndex();
+        checkedIndex = mesh.index.data();
+        checkedSize = mesh.index.size();
+    }
+};
+
+#endif //HW3_CLIP_H
@@ -0,0 +1,238 @@
+#ifndef HW3_LEVEL_INDEX_H
+#define HW3_LEVEL_INDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "array.h"
+#include "mesh.h"
+
+// Индекс треугольников по высоте для запросов объёма на одном уровне.
+//
+// Тетраэдр с вершиной d = (0, 0, h) на треугольнике abc имеет объём (det(a, b, c) - h N_z) / 6,
+// где N = a x b + b x c + c x a, -- линейная функция h. Поэтому вклад всех целиком затопленных
+// треугольников (или всех, задевающих уровень) -- префиксная сумма по треугольникам,
+// отсортированным по верхней (нижней) высоте. Разрезать приходится только треугольники,
+// которые пересекает плоскость; их находит дерево интервалов за O(log N + K).
+class LevelIndex {
+public:
+    static LevelIndex build(const Mesh &mesh) {
+        LevelIndex index;
+        size_t n = mesh.triangles();
+        if (n == 0) {
+            return index;
+        }
+        auto zs = std::minmax_element(mesh.z.begin(), mesh.z.end());
+        index.cz = (*zs.first + *zs.second) / 2;
+        std::vector<double> det(n), normal(n), low(n), high(n);
+        for (size_t i = 0; i < n; i++) {
+            const uint32_t *v = &mesh.index[i * 3];
+            double ax = mesh.x[v[0]], ay = mesh.y[v[0]], az = mesh.z[v[0]] - index.cz;
+            double bx = mesh.x[v[1]], by = mesh.y[v[1]], bz = mesh.z[v[1]] - index.cz;
+            double cx = mesh.x[v[2]], cy = mesh.y[v[2]], cz = mesh.z[v[2]] - index.cz;
+            det[i] = ax * (by * cz - bz * cy) + ay * (bz * cx - bx * cz) + az * (bx * cy - by * cx);
+            normal[i] = (ax * by - ay * bx) + (bx * cy - by * cx) + (cx * ay - cy * ax);
+            low[i] = std::min({mesh.z[v[0]], mesh.z[v[1]], mesh.z[v[2]]});
+            high[i] = std::max({mesh.z[v[0]], mesh.z[v[1]], mesh.z[v[2]]});
+        }
+        index.top = Prefix::build(high, det, normal);
+        index.bottom = Prefix::build(low, det, normal);
+
+        std::vector<uint32_t> all(n);
+        for (size_t i = 0; i < n; i++) {
+            all[i] = (uint32_t) i;
+        }
+        Tree tree;
+        tree.build(all, low, high);
+        index.nodes = std::move(tree.nodes);
+        index.byLow = std::move(tree.byLow);
+        index.byHigh = std::move(tree.byHigh);
+        index.byLowTriangle = std::move(tree.byLowTriangle);
+        index.byHighTriangle = std::move(tree.byHighTriangle);
+        return index;
+    }
+
+    // Calls f on every stored field in a fixed order, for saving and loading a compiled tank.
+    template<class F>
+    void fields(F &&f) {
+        f(cz);
+        top.fields(f);
+        bottom.fields(f);
+        f(nodes);
+        f(byLow);
+        f(byHigh);
+        f(byLowTriangle);
+        f(byHighTriangle);
+    }
+
+    size_t triangles() const noexcept {
+        return top.keys.size();
+    }
+
+    // The arrays agree in size, e.g. after mapping a compiled tank; the tree itself is checked as it is walked.
+    bool consistent() const noexcept {
+        size_t n = triangles();
+        return top.consistent() && bottom.consistent() && bottom.keys.size() == n && byLow.size() == n &&
+               byHigh.size() == n && byLowTriangle.size() == n && byHighTriangle.size() == n;
+    }
+
+    // Signed volume under the triangles lying entirely at or below the level.
+    double submerged(double level) const {
+        return top.at(level, level - cz);
+    }
+
+    // Signed volume under every triangle with at least one vertex at or below the level.
+    double touching(double level) const {
+        return bottom.at(level, level - cz);
+    }
+
+    // Calls f(triangle) for every triangle the plane cuts: lowest z <= level < highest z.
+    // A mapped tree is not checked up front, so the links and spans are checked on the way down;
+    // a root-to-leaf path of a sound tree visits every node at most once.
+    template<class F>
+    void forEachCut(double level, F &&f) const {
+        size_t depth = 0;
+        for (uint32_t node = nodes.empty() ? NONE : 0; node != NONE; depth++) {
+            if (node >= nodes.size() || depth >= nodes.size() || nodes[node].begin > nodes[node].end ||
+                nodes[node].end > byLow.size()) {
+                throw std::runtime_error("level index: damaged tree");
+            }
+            const Node &current = nodes[node];
+            if (level < current.center) {
+                // Everything here reaches above the centre, hence above the level.
+                for (uint32_t k = current.begin; k < current.end && byLow[k] <= level; k++) {
+                    f(checked(byLowTriangle[k]));
+                }
+                node = current.left;
+            } else {
+                for (uint32_t k = current.begin; k < current.end && byHigh[k] > level; k++) {
+                    f(checked(byHighTriangle[k]));
+                }
+                node = current.right;
+            }
+        }
+    }
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    uint32_t checked(uint32_t triangle) const {
+        if (triangle >= triangles()) {
+            throw std::runtime_error("level index: triangle out of range");
+        }
+        return triangle;
+    }
+
+    // Triangles sorted by a key with compensated prefix sums of det and N_z.
+    struct Prefix {
+        Array<double> keys;
+        Array<double> det;
+        Array<double> normal;
+
+        static Prefix build(const std::vector<double> &key, const std::vector<double> &det,
+                            const std::vector<double> &normal) {
+            std::vector<uint32_t> order(key.size());
+            for (size_t i = 0; i < order.size(); i++) {
+                order[i] = (uint32_t) i;
+            }
+            std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return key[a] < key[b]; });
+            std::vector<double> keys, sumDet(1, 0.0), sumNormal(1, 0.0);
+            keys.reserve(order.size());
+            double s[2] = {0, 0}, c[2] = {0, 0};
+            for (uint32_t i: order) {
+                keys.push_back(key[i]);
+                double terms[2] = {det[i], normal[i]};
+                for (int k = 0; k < 2; k++) {
+                    double y = terms[k] - c[k];
+                    double t = s[k] + y;
+                    c[k] = (t - s[k]) - y;
+                    s[k] = t;
+                }
+                sumDet.push_back(s[0]);
+                sumNormal.push_back(s[1]);
+            }
+            Prefix prefix;
+            prefix.keys = std::move(keys);
+            prefix.det = std::move(sumDet);
+            prefix.normal = std::move(sumNormal);
+            return prefix;
+        }
+
+        template<class F>
+        void fields(F &&f) {
+            f(keys);
+            f(det);
+            f(normal);
+        }
+
+        // An empty prefix has no sums at all, otherwise there is one more sum than keys.
+        bool consistent() const noexcept {
+            return (det.size() == keys.size() + 1 || (keys.empty() && det.empty())) && normal.size() == det.size();
+        }
+
+        double at(double level, double shifted) const {
+            size_t count = std::upper_bound(keys.begin(), keys.end(), level) - keys.begin();
+            return (det[count] - shifted * normal[count]) / 6.0;
+        }
+    };
+
+    struct Node {
+        double center;
+        uint32_t begin, end;
+        uint32_t left, right;
+    };
+
+    double cz = 0;
+    Prefix top, bottom;
+    // Centred interval tree: a node keeps the triangles spanning its centre twice,
+    // by lowest z ascending and by highest z descending.
+    Array<Node> nodes;
+    Array<double> byLow, byHigh;
+    Array<uint32_t> byLowTriangle, byHighTriangle;
+
+    struct Tree {
+        std::vector<Node> nodes;
+        std::vector<double> byLow, byHigh;
+        std::vector<uint32_t> byLowTriangle, byHighTriangle;
+
+        uint32_t build(std::vector<uint32_t> &triangles, const std::vector<double> &low,
+                       const std::vector<double> &high) {
+            if (triangles.empty()) {
+                return NONE;
+            }
+            // The median midpoint: each side gets at most half, so the depth is O(log N).
+            auto middle = triangles.begin() + triangles.size() / 2;
+            std::nth_element(triangles.begin(), middle, triangles.end(), [&](uint32_t a, uint32_t b) {
+                return low[a] + high[a] < low[b] + high[b];
+            });
+            double center = (low[*middle] + high[*middle]) / 2;
+            std::vector<uint32_t> left, right, here;
+            for (uint32_t t: triangles) {
+                (high[t] < center ? left : low[t] > center ? right : here).push_back(t);
+            }
+            triangles.clear();
+            triangles.shrink_to_fit();
+
+            uint32_t node = (uint32_t) nodes.size();
+            nodes.push_back({center, (uint32_t) byLow.size(), (uint32_t) (byLow.size() + here.size()), NONE, NONE});
+            std::sort(here.begin(), here.end(), [&](uint32_t a, uint32_t b) { return low[a] < low[b]; });
+            for (uint32_t t: here) {
+                byLow.push_back(low[t]);
+                byLowTriangle.push_back(t);
+            }
+            std::sort(here.begin(), here.end(), [&](uint32_t a, uint32_t b) { return high[a] > high[b]; });
+            for (uint32_t t: here) {
+                byHigh.push_back(high[t]);
+                byHighTriangle.push_back(t);
+            }
+            uint32_t leftNode = build(left, low, high);
+            uint32_t rightNode = build(right, low, high);
+            nodes[node].left = leftNode;
+            nodes[node].right = rightNode;
+            return node;
+        }
+    };
+};
+
+#endif //HW3_LEVEL_INDEX_H
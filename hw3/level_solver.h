@@ -0,0 +1,72 @@
+#ifndef HW3_LEVEL_SOLVER_H
+#define HW3_LEVEL_SOLVER_H
+
+#include <cmath>
+
+// Поиск уровня по объёму без заранее построенных таблиц. Производная объёма по уровню --
+// площадь сечения, и она считается тем же проходом по сетке, что и объём, поэтому шаг
+// Ньютона ничего не стоит сверх самого вычисления. Ньютон держится внутри вилки [lower, upper]
+// и откатывается к делению пополам, если шаг из неё выходит.
+
+struct LevelSolverOptions {
+    double levelTolerance = 1e-9;    // absolute, in units of length
+    double volumeTolerance = 1e-12;  // relative to the requested volume
+    int maxIterations = 100;
+};
+
+struct LevelSolution {
+    double level;
+    double volume;
+    int iterations;
+    int meshPasses;
+    bool converged;
+};
+
+// evaluate(h) gives {volume, area} at h, oriented so that the volume grows from 0 at lower
+// to total at upper.
+template<class Evaluate>
+LevelSolution solveLevel(double target, double lower, double upper, double total, Evaluate &&evaluate,
+                         const LevelSolverOptions &options) {
+    LevelSolution solution = {lower, 0, 0, 0, true};
+    if (!(target > 0)) {
+        return solution;
+    }
+    if (target >= total) {
+        solution.level = upper;
+        solution.volume = total;
+        return solution;
+    }
+    solution.converged = false;
+    double tolerance = options.volumeTolerance * target;
+    // The first guess pretends the tank is a prism.
+    double h = lower + (upper - lower) * (target / total);
+    while (solution.iterations < options.maxIterations) {
+        solution.iterations++;
+        auto value = evaluate(h);
+        solution.meshPasses++;
+        solution.level = h;
+        solution.volume = value.volume;
+        double f = value.volume - target;
+        if (std::fabs(f) <= tolerance) {
+            solution.converged = true;
+            break;
+        }
+        if (f > 0) {
+            upper = h;
+        } else {
+            lower = h;
+        }
+        double next = value.area > 0 ? h - f / value.area : (lower + upper) / 2;
+        if (!(next > lower && next < upper)) {
+            next = (lower + upper) / 2;
+        }
+        if (std::fabs(next - h) <= options.levelTolerance || upper - lower <= options.levelTolerance) {
+            solution.converged = true;
+            break;
+        }
+        h = next;
+    }
+    return solution;
+}
+
+#endif //HW3_LEVEL_SOLVER_H
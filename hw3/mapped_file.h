@@ -0,0 +1,67 @@
+#ifndef HW3_MAPPED_FILE_H
+#define HW3_MAPPED_FILE_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Файл, отображённый в память только для чтения. Данные не копируются:
+// страницы подгружает ядро по мере обращения.
+class MappedFile {
+public:
+    // advice -- how the pages will be read, for madvise: sequentially by a parser by default.
+    explicit MappedFile(const std::string &path, int advice = MADV_SEQUENTIAL) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error(path + ": " + std::strerror(errno));
+        }
+        struct stat info = {};
+        if (fstat(fd, &info) != 0) {
+            int error = errno;
+            close(fd);
+            throw std::runtime_error(path + ": " + std::strerror(error));
+        }
+        bytes = (size_t) info.st_size;
+        if (bytes != 0) {
+            mapping = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                int error = errno;
+                mapping = nullptr;
+                close(fd);
+                throw std::runtime_error(path + ": " + std::strerror(error));
+            }
+            madvise(mapping, bytes, advice);
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (mapping != nullptr) {
+            munmap(mapping, bytes);
+        }
+    }
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *data() const noexcept {
+        return static_cast<const char *>(mapping);
+    }
+
+    size_t size() const noexcept {
+        return bytes;
+    }
+
+private:
+    void *mapping = nullptr;
+    size_t bytes = 0;
+};
+
+#endif //HW3_MAPPED_FILE_H
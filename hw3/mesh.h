@@ -0,0 +1,108 @@
+#ifndef HW3_MESH_H
+#define HW3_MESH_H
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "array.h"
+
+// Сетка с общими вершинами: координаты лежат в трёх отдельных массивах x, y, z,
+// треугольник -- три 32-битных номера вершин в index. Совпадающие вершины STL
+// склеиваются при построении, так что каждая хранится один раз.
+class Mesh {
+public:
+    Array<double> x, y, z;
+    Array<uint32_t> index;
+
+    size_t triangles() const noexcept {
+        return index.size() / 3;
+    }
+
+    size_t vertices() const noexcept {
+        return x.size();
+    }
+
+    // The arrays agree in size. Says nothing about the values, which for a mapped compiled tank are unchecked.
+    bool consistent() const noexcept {
+        return y.size() == x.size() && z.size() == x.size() && index.size() % 3 == 0;
+    }
+
+    // Throws when a triangle refers to a vertex that does not exist, as in a damaged compiled tank.
+    void checkIndex() const {
+        uint32_t top = 0;
+        for (uint32_t v: index) {
+            top = v > top ? v : top;
+        }
+        if (!index.empty() && top >= vertices()) {
+            throw std::runtime_error("mesh: vertex index out of range");
+        }
+    }
+
+    // coords -- по 9 чисел на треугольник, как их отдаёт readStl.
+    static Mesh weld(const std::vector<double> &coords) {
+        std::vector<double> xs, ys, zs;
+        std::vector<uint32_t> index;
+        size_t corners = coords.size() / 3;
+        index.reserve(corners);
+        // Open addressing over vertex numbers; a closed mesh has about half as many vertices as triangles.
+        size_t capacity = 16;
+        while (capacity < corners) {
+            capacity *= 2;
+        }
+        std::vector<uint32_t> slots(capacity, EMPTY);
+        for (size_t i = 0; i < corners; i++) {
+            const double *p = coords.data() + i * 3;
+            size_t slot = hash(p) & (capacity - 1);
+            while (slots[slot] != EMPTY &&
+                   !(xs[slots[slot]] == p[0] && ys[slots[slot]] == p[1] && zs[slots[slot]] == p[2])) {
+                slot = (slot + 1) & (capacity - 1);
+            }
+            if (slots[slot] == EMPTY) {
+                if (xs.size() >= EMPTY) {
+                    throw std::length_error("mesh: too many vertices for 32-bit indices");
+                }
+                slots[slot] = (uint32_t) xs.size();
+                xs.push_back(p[0]);
+                ys.push_back(p[1]);
+                zs.push_back(p[2]);
+            }
+            index.push_back(slots[slot]);
+        }
+        Mesh mesh;
+        mesh.x = std::move(xs);
+        mesh.y = std::move(ys);
+        mesh.z = std::move(zs);
+        mesh.index = std::move(index);
+        return mesh;
+    }
+
+    // Calls f on every array in a fixed order, for saving and loading a compiled tank.
+    template<class F>
+    void fields(F &&f) {
+        f(x);
+        f(y);
+        f(z);
+        f(index);
+    }
+
+private:
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+
+    static uint64_t bits(double value) {
+        // -0.0 == 0.0, so both must hash alike.
+        value += 0.0;
+        uint64_t result;
+        std::memcpy(&result, &value, sizeof(result));
+        return result;
+    }
+
+    static size_t hash(const double *p) {
+        uint64_t h = bits(p[0]) * 0x9e3779b97f4a7c15ULL;
+        h = (h ^ bits(p[1])) * 0xff51afd7ed558ccdULL;
+        h = (h ^ bits(p[2])) * 0xc4ceb9fe1a85ec53ULL;
+        return (size_t) (h ^ (h >> 29));
+    }
+};
+
+#endif //HW3_MESH_H
@@ -0,0 +1,142 @@
+#ifndef HW3_MULTISTART_H
+#define HW3_MULTISTART_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "parallel.h"
+
+// Мультистарт: много запусков одного метода из случайных начальных точек на пуле потоков.
+//
+// Случайные числа запуска зависят только от зерна и номера запуска (генератор на счётчике),
+// а итоги блоков складываются в порядке блоков, так что результат одинаков при любом числе
+// потоков и любом порядке, в котором потоки разобрали блоки.
+
+// Counter-based generator: the k-th number of stream s is a hash of (seed, s, k), nothing is shared
+// between streams and any stream can start anywhere.
+class CounterRng {
+public:
+    CounterRng(uint64_t seed, uint64_t stream) : key(mix(seed ^ mix(stream + 0x632be59bd9b4e019ULL))) {
+    }
+
+    uint64_t next() {
+        return mix(key + 0x9e3779b97f4a7c15ULL * ++counter);
+    }
+
+    // Uniform in [low, high) with 53 random bits.
+    double uniform(double low, double high) {
+        return low + (high - low) * ((double) (next() >> 11) * 0x1.0p-53);
+    }
+
+private:
+    uint64_t key;
+    uint64_t counter = 0;
+
+    // SplitMix64 finalizer.
+    static uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+};
+
+template<class Point>
+struct MultistartStats {
+    size_t starts = 0;
+    size_t hits = 0;
+    long long steps = 0;
+    int maxSteps = 0;
+    Point best{};
+    double bestValue = std::numeric_limits<double>::infinity();
+    size_t bestStart = 0;
+
+    double hitRate() const {
+        return starts == 0 ? 0 : (double) hits / (double) starts;
+    }
+
+    double averageSteps() const {
+        return starts == 0 ? 0 : (double) steps / (double) starts;
+    }
+
+    void add(size_t start, const Point &point, int runSteps, double value, double hitTolerance) {
+        starts++;
+        hits += value < hitTolerance;
+        steps += runSteps;
+        maxSteps = std::max(maxSteps, runSteps);
+        if (value < bestValue || (value == bestValue && start < bestStart)) {
+            best = point;
+            bestValue = value;
+            bestStart = start;
+        }
+    }
+
+    // Ties go to the lower start number, so merging order does not matter for the best point either.
+    void merge(const MultistartStats &other) {
+        starts += other.starts;
+        hits += other.hits;
+        steps += other.steps;
+        maxSteps = std::max(maxSteps, other.maxSteps);
+        if (other.bestValue < bestValue || (other.bestValue == bestValue && other.bestStart < bestStart)) {
+            best = other.best;
+            bestValue = other.bestValue;
+            bestStart = other.bestStart;
+        }
+    }
+};
+
+// Starts handed to a thread at a time: enough to amortize the hand-out, small enough to balance.
+const size_t MULTISTART_BLOCK = 1024;
+
+// start(rng) draws the input of a run, solve(input) returns {point, steps}, value(point) is the objective;
+// a run hits when value is below hitTolerance. Idle threads take the next block from the pool's shared
+// counter, so long runs in one block do not hold up the others.
+template<class Start, class Solve, class Value>
+auto multistart(ThreadPool &pool, size_t starts, uint64_t seed, Start &&start, Solve &&solve, Value &&value,
+                double hitTolerance) {
+    CounterRng probe(seed, 0);
+    using Point = decltype(solve(start(probe)).point);
+    size_t blocks = (starts + MULTISTART_BLOCK - 1) / MULTISTART_BLOCK;
+    std::vector<MultistartStats<Point>> partial(blocks);
+    pool.run(blocks, [&](size_t block) {
+        MultistartStats<Point> &stats = partial[block];
+        size_t last = std::min(starts, (block + 1) * MULTISTART_BLOCK);
+        for (size_t i = block * MULTISTART_BLOCK; i < last; i++) {
+            CounterRng rng(seed, i);
+            auto result = solve(start(rng));
+            stats.add(i, result.point, result.steps, value(result.point), hitTolerance);
+        }
+    });
+    MultistartStats<Point> total;
+    for (const auto &stats: partial) {
+        total.merge(stats);
+    }
+    return total;
+}
+
+// The same for a solver that advances a whole block of starts together: solveBlock(first, last, input, finish)
+// gets the input of start i from input(i) and reports its result with finish(i, result), in any order.
+template<class Point, class Start, class SolveBlock, class Value>
+MultistartStats<Point> multistartBlocks(ThreadPool &pool, size_t starts, uint64_t seed, Start &&start,
+                                        SolveBlock &&solveBlock, Value &&value, double hitTolerance) {
+    size_t blocks = (starts + MULTISTART_BLOCK - 1) / MULTISTART_BLOCK;
+    std::vector<MultistartStats<Point>> partial(blocks);
+    pool.run(blocks, [&](size_t block) {
+        MultistartStats<Point> &stats = partial[block];
+        size_t first = block * MULTISTART_BLOCK;
+        solveBlock(first, std::min(starts, first + MULTISTART_BLOCK), [&](size_t i) {
+            CounterRng rng(seed, i);
+            return start(rng);
+        }, [&](size_t i, const auto &result) {
+            stats.add(i, result.point, result.steps, value(result.point), hitTolerance);
+        });
+    });
+    MultistartStats<Point> total;
+    for (const auto &stats: partial) {
+        total.merge(stats);
+    }
+    return total;
+}
+
+#endif //HW3_MULTISTART_H
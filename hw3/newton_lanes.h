@@ -0,0 +1,101 @@
+#ifndef HW3_NEWTON_LANES_H
+#define HW3_NEWTON_LANES_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "solver.h"
+
+// Метод Ньютона сразу для многих начальных точек: блок точек хранится по координатам
+// (x[i][lane] подряд по lane), и производные на каждом шаге считаются одним вызовом
+// F::derivatives на всю координату, где sin и cos идут по четыре в регистре.
+// Сошедшийся запуск отдаётся наружу, а его место сразу занимает следующая начальная точка,
+// так что полосы не простаивают, пока досчитываются самые долгие запуски.
+//
+// Каждая полоса делает ровно те же операции, что newton<F>, поэтому результат запуска
+// побитово совпадает с ним.
+
+// Starts advanced together: a few cache lines per coordinate, many AVX registers of work per call.
+const size_t NEWTON_LANES = 64;
+
+// Runs newton<F> from start(i) for every i in [first, last) and calls finish(i, result) for each run
+// as soon as it stops, in no particular order.
+template<class F, size_t N, class Start, class Finish>
+void newtonLanes(size_t first, size_t last, Start &&start, Finish &&finish, const SolverOptions &options = {}) {
+    const size_t L = NEWTON_LANES;
+    std::vector<double> x(N * L), next(N * L), value(L), der(L);
+    std::vector<size_t> run(L);
+    std::vector<int> steps(L);
+    std::vector<unsigned char> flat(L), stationary(L), moved(L), advance(L);
+    size_t queued = first;
+    auto load = [&](size_t lane) {
+        PointN<N> p = start(queued);
+        for (size_t i = 0; i < N; i++) {
+            x[i * L + lane] = p[i];
+        }
+        run[lane] = queued++;
+        steps[lane] = 0;
+    };
+    // Lanes 0..width-1 are busy. Once the queue is empty the width shrinks, so the few longest runs
+    // of a block do not drag a full block of idle lanes through every step.
+    size_t width = std::min(L, last - first);
+    for (size_t lane = 0; lane < width; lane++) {
+        load(lane);
+    }
+    while (width > 0) {
+        std::fill(flat.begin(), flat.end(), 1);
+        std::fill(stationary.begin(), stationary.end(), 1);
+        std::fill(moved.begin(), moved.end(), 0);
+        for (size_t i = 0; i < N; i++) {
+            const double *p = &x[i * L];
+            double *n = &next[i * L];
+            F::derivatives(p, value.data(), der.data(), width);
+            for (size_t lane = 0; lane < width; lane++) {
+                bool usable = std::fabs(der[lane]) >= options.epsF;
+                flat[lane] &= !usable;
+                stationary[lane] &= std::fabs(value[lane]) < options.epsF;
+                n[lane] = usable ? p[lane] - value[lane] / der[lane] : p[lane];
+                moved[lane] |= std::fabs(n[lane] - p[lane]) >= options.epsX;
+            }
+        }
+        // newton<F> checks the step limit before computing the step, here it comes after: the lanes
+        // at the limit waste one evaluation, the results are the same.
+        for (size_t lane = 0; lane < width; lane++) {
+            advance[lane] = steps[lane] <= options.maxSteps && !(stationary[lane] || flat[lane] || !moved[lane]);
+            steps[lane] += advance[lane];
+        }
+        for (size_t i = 0; i < N; i++) {
+            for (size_t lane = 0; lane < width; lane++) {
+                x[i * L + lane] = advance[lane] ? next[i * L + lane] : x[i * L + lane];
+            }
+        }
+        size_t lane = 0;
+        while (lane < width) {
+            if (advance[lane]) {
+                lane++;
+                continue;
+            }
+            SolverResult<N> result{{}, steps[lane]};
+            for (size_t i = 0; i < N; i++) {
+                result.point[i] = x[i * L + lane];
+            }
+            finish(run[lane], result);
+            if (queued < last) {
+                load(lane);
+                lane++;
+                continue;
+            }
+            // The last busy lane takes this place and is looked at again: it may have stopped too.
+            width--;
+            for (size_t i = 0; i < N; i++) {
+                x[i * L + lane] = x[i * L + width];
+            }
+            run[lane] = run[width];
+            steps[lane] = steps[width];
+            advance[lane] = advance[width];
+        }
+    }
+}
+
+#endif //HW3_NEWTON_LANES_H
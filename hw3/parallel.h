@@ -0,0 +1,101 @@
+#ifndef HW3_PARALLEL_H
+#define HW3_PARALLEL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков: run() раздаёт номера задач [0, tasks) и ждёт, пока все выполнятся.
+// Вызывающий поток тоже работает, так что ThreadPool(1) не создаёт потоков вовсе.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency()) {
+        for (unsigned i = 1; i < threads; i++) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &worker: workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    unsigned size() const noexcept {
+        return (unsigned) workers.size() + 1;
+    }
+
+    void run(size_t tasks, const std::function<void(size_t)> &task) {
+        if (workers.empty() || tasks <= 1) {
+            for (size_t i = 0; i < tasks; i++) {
+                task(i);
+            }
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &task;
+            jobSize = tasks;
+            next = 0;
+            busy = workers.size();
+            generation++;
+        }
+        wake.notify_all();
+        drain();
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return busy == 0; });
+        job = nullptr;
+    }
+
+private:
+    void drain() {
+        for (size_t i = next++; i < jobSize; i = next++) {
+            (*job)(i);
+        }
+    }
+
+    void workerLoop() {
+        unsigned seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) {
+                    return;
+                }
+                seen = generation;
+            }
+            drain();
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busy == 0) {
+                done.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t)> *job = nullptr;
+    size_t jobSize = 0;
+    std::atomic<size_t> next{0};
+    size_t busy = 0;
+    unsigned generation = 0;
+    bool stopping = false;
+};
+
+#endif //HW3_PARALLEL_H
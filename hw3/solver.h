@@ -0,0 +1,160 @@
+#ifndef HW3_SOLVER_H
+#define HW3_SOLVER_H
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include "sincos.h"
+
+// Поиск нуля производной сепарабельной функции f(x) = sum g(x_i) в N измерениях: бисекция по
+// отрезку и метод Ньютона. Размерность известна при компиляции, так что циклы по координатам
+// разворачиваются и векторизуются; обе функции итеративные, глубина стека от числа шагов не зависит.
+//
+// Целевая функция -- тип со статическими of1d(x) = g(x), deriv1d(x) = g'(x) и secondDeriv1d(x) = g''(x);
+// для newtonLanes ещё derivatives(x, first, second, n) -- g' и g'' сразу в n точках.
+
+template<size_t N>
+struct PointN {
+    std::array<double, N> x;
+
+    // No range check: coordinate loops are over 0..N-1 only.
+    double &operator[](size_t i) {
+        return x[i];
+    }
+
+    const double &operator[](size_t i) const {
+        return x[i];
+    }
+
+    static PointN midpoint(const PointN &a, const PointN &b) {
+        PointN mid;
+        for (size_t i = 0; i < N; i++) {
+            mid[i] = (a[i] + b[i]) / 2;
+        }
+        return mid;
+    }
+};
+
+// sin and cos come from turns::sincos, so the scalar solvers and newtonLanes see the same bits.
+struct Rastrigin {
+    static double of1d(double x) {
+        double s, c;
+        turns::sincos(x, s, c);
+        return 10.0 + x * x - 10 * c;
+    }
+
+    static double deriv1d(double x) {
+        double s, c;
+        turns::sincos(x, s, c);
+        return 2.0 * x + 20 * M_PI * s;
+    }
+
+    static double secondDeriv1d(double x) {
+        double s, c;
+        turns::sincos(x, s, c);
+        return 2 + 40 * M_PI * M_PI * c;
+    }
+
+    // deriv1d and secondDeriv1d at n points at once.
+    static void derivatives(const double *x, double *first, double *second, size_t n) {
+        // Sines and cosines first, in place.
+        turns::sincos(x, first, second, n);
+        for (size_t i = 0; i < n; i++) {
+            first[i] = 2.0 * x[i] + 20 * M_PI * first[i];
+            second[i] = 2 + 40 * M_PI * M_PI * second[i];
+        }
+    }
+
+    template<size_t N>
+    static double of(const PointN<N> &p) {
+        double sum = 0;
+        for (size_t i = 0; i < N; i++) {
+            sum += of1d(p[i]);
+        }
+        return sum;
+    }
+
+    template<size_t N>
+    static double absOf(const PointN<N> &p) {
+        return std::fabs(of(p));
+    }
+};
+
+struct SolverOptions {
+    double epsF = 1e-3;
+    double epsX = 1e-3;
+    int maxSteps = 10000;
+    // bisect: also stop once the box is thinner than N epsX. The original 1d bisection had no such stop
+    // and ran to maxSteps after the bracket collapsed; 1d-optimize turns it off to keep its statistics.
+    bool stopOnWidth = true;
+};
+
+template<size_t N>
+struct SolverResult {
+    PointN<N> point;
+    int steps;
+};
+
+// Halves the box [a, b] along the first coordinate whose derivative still changes sign on it (the last one
+// if none does) and keeps the half where it changes sign. Stops when f is below N epsF at the midpoint or,
+// with stopOnWidth, when the box is thinner than N epsX in the L1 norm.
+template<class F, size_t N>
+SolverResult<N> bisect(PointN<N> a, PointN<N> b, const SolverOptions &options = {}) {
+    for (int step = 0;; step++) {
+        PointN<N> mid = PointN<N>::midpoint(a, b);
+        if (step > options.maxSteps) {
+            return {mid, step};
+        }
+        if (std::fabs(F::of(mid)) < N * options.epsF) {
+            return {mid, step};
+        }
+        double width = 0;
+        for (size_t i = 0; i < N; i++) {
+            width += std::fabs(a[i] - b[i]);
+        }
+        if (options.stopOnWidth && width < N * options.epsX) {
+            return {mid, step};
+        }
+        size_t dim = N - 1;
+        for (size_t i = 0; i + 1 < N; i++) {
+            if (std::fabs(a[i] - b[i]) > options.epsX && F::deriv1d(a[i]) * F::deriv1d(b[i]) < 0.0) {
+                dim = i;
+                break;
+            }
+        }
+        if (F::deriv1d(a[dim]) * F::deriv1d(mid[dim]) < 0.0) {
+            b[dim] = mid[dim];
+        } else {
+            a[dim] = mid[dim];
+        }
+    }
+}
+
+// Newton on the gradient with the diagonal Hessian, which is exact for a separable f. Coordinates with
+// a second derivative below epsF stay put. Stops when the gradient is below epsF in every coordinate,
+// when no coordinate can move, or when no coordinate moves by epsX or more.
+template<class F, size_t N>
+SolverResult<N> newton(PointN<N> p, const SolverOptions &options = {}) {
+    for (int step = 0;; step++) {
+        if (step > options.maxSteps) {
+            return {p, step};
+        }
+        PointN<N> next;
+        bool flat = true, stationary = true, moved = false;
+        for (size_t i = 0; i < N; i++) {
+            double value = F::deriv1d(p[i]);
+            double der = F::secondDeriv1d(p[i]);
+            bool usable = std::fabs(der) >= options.epsF;
+            flat &= !usable;
+            stationary &= std::fabs(value) < options.epsF;
+            next[i] = usable ? p[i] - value / der : p[i];
+            moved |= std::fabs(next[i] - p[i]) >= options.epsX;
+        }
+        if (stationary || flat || !moved) {
+            return {p, step};
+        }
+        p = next;
+    }
+}
+
+#endif //HW3_SOLVER_H
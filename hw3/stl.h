@@ -0,0 +1,329 @@
+#ifndef HW3_STL_H
+#define HW3_STL_H
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mapped_file.h"
+
+// Чтение STL, текстового и двоичного. Файл отображается в память и разбирается на месте,
+// без построчных строк и потоков ввода; большие файлы режутся на куски по потокам.
+// Результат -- плоский массив координат, по 9 чисел (три вершины) на треугольник.
+
+namespace stl {
+
+    const size_t BINARY_HEADER = 80;
+    const size_t BINARY_RECORD = 50;
+    // Smaller pieces are not worth a thread.
+    const size_t MIN_PART_BYTES = 1 << 20;
+
+    inline bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+    }
+
+    inline const char *parseNumber(const char *p, const char *end, double &value) {
+        while (p < end && isSpace(*p)) {
+            p++;
+        }
+        // from_chars does not accept an explicit plus sign.
+        if (p < end && *p == '+') {
+            p++;
+        }
+        auto result = std::from_chars(p, end, value);
+        if (result.ec != std::errc()) {
+            throw std::runtime_error("stl: bad number near '" + std::string(p, std::min<size_t>(end - p, 16)) + "'");
+        }
+        return result.ptr;
+    }
+
+    // The first "facet" keyword at or after from; "endfacet" does not count.
+    inline const char *nextFacet(const char *begin, const char *from, const char *end) {
+        static const char keyword[] = "facet";
+        const size_t length = sizeof(keyword) - 1;
+        for (const char *p = from;; p++) {
+            p = std::search(p, end, keyword, keyword + length);
+            if (p == end) {
+                return end;
+            }
+            if ((p == begin || isSpace(p[-1])) && (end - p == (ptrdiff_t) length || isSpace(p[length]))) {
+                return p;
+            }
+        }
+    }
+
+    inline void parseAscii(const char *p, const char *end, std::vector<double> &out) {
+        double vertices[9];
+        int count = 0;
+        while (true) {
+            while (p < end && isSpace(*p)) {
+                p++;
+            }
+            if (p == end) {
+                break;
+            }
+            const char *token = p;
+            while (p < end && !isSpace(*p)) {
+                p++;
+            }
+            size_t length = p - token;
+            if (length == 6 && std::memcmp(token, "vertex", 6) == 0) {
+                if (count == 9) {
+                    throw std::runtime_error("stl: more than three vertices in a facet");
+                }
+                for (int k = 0; k < 3; k++) {
+                    p = parseNumber(p, end, vertices[count++]);
+                }
+            } else if (length == 7 && std::memcmp(token, "endloop", 7) == 0) {
+                if (count != 9) {
+                    throw std::runtime_error("stl: facet without three vertices");
+                }
+                out.insert(out.end(), vertices, vertices + 9);
+                count = 0;
+            }
+        }
+    }
+
+    inline void parseBinary(const char *records, size_t first, size_t last, double *out) {
+        for (size_t i = first; i < last; i++) {
+            // 12 bytes of normal, 3 vertices of 3 floats, 2 bytes of attributes.
+            float vertices[9];
+            std::memcpy(vertices, records + i * BINARY_RECORD + 12, sizeof(vertices));
+            for (int k = 0; k < 9; k++) {
+                out[i * 9 + k] = vertices[k];
+            }
+        }
+    }
+
+    inline bool isBinary(const char *data, size_t size) {
+        if (size < BINARY_HEADER + 4) {
+            return false;
+        }
+        uint32_t count;
+        std::memcpy(&count, data + BINARY_HEADER, sizeof(count));
+        // Binary files may start with "solid" too, so trust the size rather than the header text.
+        return size == BINARY_HEADER + 4 + (size_t) count * BINARY_RECORD;
+    }
+
+    // Runs part(0..parts-1) on separate threads and rethrows the first error.
+    template<class Part>
+    void runParts(size_t parts, const Part &part) {
+        std::vector<std::exception_ptr> errors(parts);
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < parts; i++) {
+            threads.emplace_back([&, i] {
+                try {
+                    part(i);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+        try {
+            part(0);
+        } catch (...) {
+            errors[0] = std::current_exception();
+        }
+        for (auto &thread: threads) {
+            thread.join();
+        }
+        for (auto &error: errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+    // Text STL cut into whole facets.
+    inline std::vector<double> parseText(const char *data, size_t size, unsigned threads) {
+        size_t parts = std::max<size_t>(1, std::min<size_t>(threads, size / MIN_PART_BYTES));
+        // Every part starts at a facet, so facets never straddle two parts.
+        const char *end = data + size;
+        std::vector<const char *> bounds(parts + 1, end);
+        bounds[0] = data;
+        for (size_t i = 1; i < parts; i++) {
+            bounds[i] = nextFacet(data, std::max(bounds[i - 1], data + size * i / parts), end);
+        }
+        std::vector<std::vector<double>> pieces(parts);
+        runParts(parts, [&](size_t i) {
+            pieces[i].reserve((bounds[i + 1] - bounds[i]) / 30);
+            parseAscii(bounds[i], bounds[i + 1], pieces[i]);
+        });
+        if (parts == 1) {
+            return std::move(pieces[0]);
+        }
+        size_t total = 0;
+        for (auto &piece: pieces) {
+            total += piece.size();
+        }
+        std::vector<double> coords;
+        coords.reserve(total);
+        for (auto &piece: pieces) {
+            coords.insert(coords.end(), piece.begin(), piece.end());
+        }
+        return coords;
+    }
+
+    // count binary records following each other.
+    inline std::vector<double> parseRecords(const char *records, size_t count, unsigned threads) {
+        size_t parts = std::max<size_t>(1, std::min<size_t>(threads, count * BINARY_RECORD / MIN_PART_BYTES));
+        std::vector<double> coords(count * 9);
+        runParts(parts, [&](size_t i) {
+            parseBinary(records, count * i / parts, count * (i + 1) / parts, coords.data());
+        });
+        return coords;
+    }
+
+    inline std::vector<double> parse(const char *data, size_t size, unsigned threads) {
+        if (isBinary(data, size)) {
+            return parseRecords(data + BINARY_HEADER + 4, (size - BINARY_HEADER - 4) / BINARY_RECORD, threads);
+        }
+        return parseText(data, size, threads);
+    }
+
+    // Where to cut a text block so that it ends with whole facets: the start of the last "facet"
+    // keyword known to be complete, or begin if there is none past it.
+    inline const char *lastFacet(const char *begin, const char *end) {
+        static const char keyword[] = "facet";
+        const size_t length = sizeof(keyword) - 1;
+        for (const char *p = end - (ptrdiff_t) length - 1; p > begin; p--) {
+            if (isSpace(p[-1]) && std::memcmp(p, keyword, length) == 0 && isSpace(p[length])) {
+                return p;
+            }
+        }
+        return begin;
+    }
+
+    // Reads an STL of any size in blocks of about blockBytes with read(2), so memory stays bounded;
+    // next() returns the triangles of the following block, cut at facet boundaries for text files.
+    class ChunkReader {
+    public:
+        ChunkReader(const std::string &path, size_t blockBytes, unsigned threads)
+                : path(path), blockBytes(std::max<size_t>(blockBytes, BINARY_RECORD)), threads(threads) {
+            fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::runtime_error(path + ": " + std::strerror(errno));
+            }
+            struct stat info = {};
+            if (fstat(fd, &info) != 0) {
+                int error = errno;
+                ::close(fd);
+                throw std::runtime_error(path + ": " + std::strerror(error));
+            }
+            size = (uint64_t) info.st_size;
+            posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+            char header[BINARY_HEADER + 4];
+            size_t got = fill(header, std::min<uint64_t>(size, sizeof(header)));
+            // isBinary looks at the triangle count in the header and the total size only.
+            binary = got == sizeof(header) && isBinary(header, size);
+            if (binary) {
+                records = (size - sizeof(header)) / BINARY_RECORD;
+            } else {
+                buffer.assign(header, header + got);
+            }
+        }
+
+        ~ChunkReader() {
+            ::close(fd);
+        }
+
+        ChunkReader(const ChunkReader &) = delete;
+
+        ChunkReader &operator=(const ChunkReader &) = delete;
+
+        // Empty coords at the end of the file.
+        std::vector<double> next() {
+            try {
+                return binary ? nextBinary() : nextText();
+            } catch (const std::runtime_error &error) {
+                throw std::runtime_error(path + ": " + error.what());
+            }
+        }
+
+    private:
+        std::string path;
+        size_t blockBytes;
+        unsigned threads;
+        int fd = -1;
+        uint64_t size = 0;
+        uint64_t position = 0;
+        bool binary = false;
+        uint64_t records = 0;
+        std::vector<char> buffer;
+
+        size_t fill(char *out, size_t bytes) {
+            size_t done = 0;
+            while (done < bytes) {
+                ssize_t got = ::read(fd, out + done, bytes - done);
+                if (got < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (got < 0) {
+                    throw std::runtime_error(std::strerror(errno));
+                }
+                if (got == 0) {
+                    break;
+                }
+                done += (size_t) got;
+            }
+            position += done;
+            return done;
+        }
+
+        std::vector<double> nextBinary() {
+            size_t count = (size_t) std::min<uint64_t>(records, blockBytes / BINARY_RECORD);
+            buffer.resize(count * BINARY_RECORD);
+            if (fill(buffer.data(), buffer.size()) != buffer.size()) {
+                throw std::runtime_error("stl: file shrank while reading");
+            }
+            records -= count;
+            return parseRecords(buffer.data(), count, threads);
+        }
+
+        std::vector<double> nextText() {
+            // The buffer starts with the unparsed tail of the previous block.
+            while (true) {
+                size_t carried = buffer.size();
+                buffer.resize(carried + blockBytes);
+                buffer.resize(carried + fill(buffer.data() + carried, blockBytes));
+                const char *begin = buffer.data(), *end = begin + buffer.size();
+                if (position >= size || buffer.size() == carried) {
+                    std::vector<double> coords = parseText(begin, buffer.size(), threads);
+                    buffer.clear();
+                    return coords;
+                }
+                const char *cut = lastFacet(begin, end);
+                if (cut != begin) {
+                    std::vector<double> coords = parseText(begin, cut - begin, threads);
+                    buffer.erase(buffer.begin(), buffer.begin() + (cut - begin));
+                    if (!coords.empty()) {
+                        return coords;
+                    }
+                }
+                // No facet ends in this block (or only the "solid" line was there): read on.
+            }
+        }
+    };
+
+}
+
+inline std::vector<double> readStl(const std::string &path,
+                                   unsigned threads = std::max(1u, std::thread::hardware_concurrency())) {
+    MappedFile file(path);
+    try {
+        return stl::parse(file.data(), file.size(), threads);
+    } catch (const std::runtime_error &error) {
+        throw std::runtime_error(path + ": " + error.what());
+    }
+}
+
+#endif //HW3_STL_H
@@ -0,0 +1,141 @@
+#ifndef HW3_STREAM_VOLUME_H
+#define HW3_STREAM_VOLUME_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <future>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+#include "clip.h"
+#include "stl.h"
+
+// Объём под уровнями прямо из файла STL, не загружая сетку: треугольники идут блоками
+// ограниченного размера, и каждый блок сразу сворачивается в суммы для всех уровней.
+// Пока один блок суммируется, следующий уже читается и разбирается, поэтому память -- два
+// блока треугольников и буфер чтения, какого бы размера ни был файл.
+//
+// Конус с вершиной (0, 0, h) над целиком затопленным треугольником равен (det - h N_z) / 6
+// (см. level_index.h), так что такой треугольник добавляет det и N_z к корзине первого уровня
+// не ниже своей верхней вершины, а после всех блоков корзины складываются префиксно.
+// Срезать приходится только треугольники, которые уровень пересекает.
+
+// Bytes of STL per block: two parsed blocks of text take about 0.6 of this, of binary about 3 times.
+const size_t STREAM_BLOCK_BYTES = 16 << 20;
+
+// Neumaier summation: a closed scan mesh sums millions of terms of both signs.
+struct CompensatedSum {
+    double sum = 0;
+    double correction = 0;
+
+    void add(double value) {
+        double t = sum + value;
+        correction += std::fabs(sum) >= std::fabs(value) ? (sum - t) + value : (value - t) + sum;
+        sum = t;
+    }
+
+    double value() const {
+        return sum + correction;
+    }
+};
+
+class StreamVolumes {
+public:
+    explicit StreamVolumes(const std::vector<double> &levels) : order(levels.size()) {
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return levels[a] < levels[b]; });
+        for (size_t i: order) {
+            sorted.push_back(levels[i]);
+        }
+        det.resize(sorted.size() + 1);
+        normal.resize(sorted.size() + 1);
+        cut.resize(sorted.size());
+    }
+
+    // coords -- 9 numbers per triangle, as readStl returns them.
+    void add(const std::vector<double> &coords) {
+        size_t triangles = coords.size() / 9;
+        if (triangles == 0) {
+            return;
+        }
+        // Any point on the plane serves as the apex, so the first vertex is taken as the origin:
+        // a scan far from (0, 0, 0) would otherwise lose digits in det.
+        if (!started) {
+            origin[0] = coords[0];
+            origin[1] = coords[1];
+            origin[2] = coords[2];
+            for (size_t k = 0; k < sorted.size(); k++) {
+                shifted.push_back(sorted[k] - origin[2]);
+            }
+            started = true;
+        }
+        for (size_t i = 0; i < triangles; i++) {
+            const double *p = coords.data() + i * 9;
+            double ax = p[0] - origin[0], ay = p[1] - origin[1], az = p[2] - origin[2];
+            double bx = p[3] - origin[0], by = p[4] - origin[1], bz = p[5] - origin[2];
+            double cx = p[6] - origin[0], cy = p[7] - origin[1], cz = p[8] - origin[2];
+            double full = ax * (by * cz - bz * cy) + ay * (bz * cx - bx * cz) + az * (bx * cy - by * cx);
+            double nz = (ax * by - ay * bx) + (bx * cy - by * cx) + (cx * ay - cy * ax);
+            total.add(full);
+            double low = std::min({az, bz, cz}), high = std::max({az, bz, cz});
+            size_t first = std::lower_bound(shifted.begin(), shifted.end(), low) - shifted.begin();
+            size_t whole = std::lower_bound(shifted.begin() + first, shifted.end(), high) - shifted.begin();
+            det[whole].add(full);
+            normal[whole].add(nz);
+            // low <= level < high: the plane cuts this triangle.
+            for (size_t k = first; k < whole; k++) {
+                cut[k].add(clip::volume(ax, ay, az, bx, by, bz, cx, cy, cz, shifted[k]));
+            }
+        }
+    }
+
+    // Volumes in the order the levels were given; the sign follows from the total so either
+    // orientation of the mesh works.
+    std::vector<double> volumes() const {
+        double sign = total.value() < 0 ? -1 : 1;
+        std::vector<double> result(sorted.size());
+        CompensatedSum d, n;
+        for (size_t k = 0; k < sorted.size(); k++) {
+            d.add(det[k].value());
+            n.add(normal[k].value());
+            double volume = (d.value() - shifted[k] * n.value()) / 6.0 + cut[k].value();
+            result[order[k]] = sign * volume;
+        }
+        return result;
+    }
+
+private:
+    std::vector<size_t> order;
+    std::vector<double> sorted;
+    std::vector<double> shifted;
+    double origin[3] = {0, 0, 0};
+    bool started = false;
+    CompensatedSum total;
+    // det[k], normal[k] -- triangles lying entirely at or below level k but not level k - 1.
+    std::vector<CompensatedSum> det, normal;
+    std::vector<CompensatedSum> cut;
+};
+
+// Volumes below the levels straight from the STL file, in bounded memory whatever its size.
+// The next block is read and parsed on another thread while the current one is summed.
+inline std::vector<double> streamVolumes(const std::string &path, const std::vector<double> &levels,
+                                         size_t blockBytes = STREAM_BLOCK_BYTES,
+                                         unsigned threads = std::max(1u, std::thread::hardware_concurrency())) {
+    stl::ChunkReader reader(path, blockBytes, threads);
+    StreamVolumes volumes(levels);
+    std::vector<double> current = reader.next();
+    while (!current.empty()) {
+        std::future<std::vector<double>> next = std::async(std::launch::async, [&] { return reader.next(); });
+        volumes.add(current);
+        current = next.get();
+    }
+    return volumes.volumes();
+}
+
+inline double streamVolume(const std::string &path, double level, size_t blockBytes = STREAM_BLOCK_BYTES) {
+    return streamVolumes(path, {level}, blockBytes)[0];
+}
+
+#endif //HW3_STREAM_VOLUME_H
@@ -0,0 +1,221 @@
+#ifndef HW3_TANK_H
+#define HW3_TANK_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "stl.h"
+#include "mesh.h"
+#include "volume_curve.h"
+#include "level_index.h"
+#include "clip.h"
+#include "level_solver.h"
+#include "tilt.h"
+#include "tank_cache.h"
+
+// Бак: сетка из STL и запросы объёма и уровня по ней.
+
+class Point {
+public:
+    Point() : x(0), y(0), z(0) {}
+
+    Point(double x, double y, double z) : x(x), y(y), z(z) {}
+
+    double x, y, z;
+
+    void print() const {
+        std::cout << std::fixed << std::setprecision(3) << "Point: " << "x = " << x << ", " << "y = " << y
+                  << ", z = " << z << std::endl;
+    }
+};
+
+// Liquid at a level: what stability and heat-loss calculations need besides the volume.
+struct LiquidState {
+    double volume;
+    Point centroid;
+    double wettedArea;
+    double freeSurfaceArea;
+};
+
+class Tank {
+public:
+    Mesh mesh;
+    VolumeCurve curve;
+    LevelIndex index;
+    // +1 for an outward-facing mesh, -1 for an inward-facing one.
+    double orientation = 1;
+
+    bool inited = false;
+    double lowestPoint;
+    double highestPoint;
+
+    // Loads from the compiled tank at cachePath when it was built from this STL,
+    // otherwise reads the STL and writes the compiled tank for the next start. The cache is only
+    // a shortcut: when it cannot be written, the error goes to stderr and the tank read from the STL stays.
+    void load(const std::string &stlPath, const std::string &cachePath) {
+        std::shared_ptr<const MappedFile> mapping = tank_cache::open(cachePath, stlPath, *this);
+        if (mapping) {
+            storage = mapping;
+            inited = mesh.vertices() > 0;
+            return;
+        }
+        read(stlPath);
+        try {
+            tank_cache::save(cachePath, stlPath, *this);
+        } catch (const std::runtime_error &error) {
+            std::cerr << "tank cache not written: " << error.what() << std::endl;
+        }
+    }
+
+    // Calls f on every stored field in a fixed order, for the compiled tank.
+    template<class F>
+    void fields(F &&f) {
+        f(lowestPoint);
+        f(highestPoint);
+        f(orientation);
+        mesh.fields(f);
+        curve.fields(f);
+        index.fields(f);
+    }
+
+    // The stored arrays agree in size with each other, for a freshly mapped compiled tank.
+    bool consistent() const noexcept {
+        return mesh.consistent() && curve.consistent() && index.consistent() && index.triangles() == mesh.triangles();
+    }
+
+    void read(const std::string &filename) {
+        mesh = Mesh::weld(readStl(filename));
+        inited = mesh.vertices() > 0;
+        if (inited) {
+            auto range = std::minmax_element(mesh.z.begin(), mesh.z.end());
+            lowestPoint = *range.first;
+            highestPoint = *range.second;
+        }
+        curve = VolumeCurve::build(mesh);
+        index = LevelIndex::build(mesh);
+        orientation = inited && index.submerged(highestPoint) < 0 ? -1 : 1;
+        storage.reset();
+    }
+
+    double getVolumeByLevelNoSplit(double level) const {
+        return std::fabs(index.touching(level));
+    }
+
+    // Whole triangles below the level come from prefix sums, only the K cut ones are clipped.
+    double getVolumeByLevelWithSplit(double level) const {
+        double sum = index.submerged(level);
+        index.forEachCut(level, [&](uint32_t i) {
+            const uint32_t *v = corners(i);
+            sum += clip::volume(mesh.x[v[0]], mesh.y[v[0]], mesh.z[v[0]], mesh.x[v[1]], mesh.y[v[1]], mesh.z[v[1]],
+                                mesh.x[v[2]], mesh.y[v[2]], mesh.z[v[2]], level);
+        });
+        return std::fabs(sum);
+    }
+
+    // The same volume by a full vectorized scan over all triangles on the scanner's threads.
+    double getVolumeByLevelWithSplit(double level, VolumeScanner &scanner) const {
+        return std::fabs(scanner.volume(mesh, level));
+    }
+
+    // Volume and cross-section area at the level from one pass over the cut faces.
+    clip::Wet getWetByLevel(double level) const {
+        clip::Wet sum = {index.submerged(level), 0};
+        index.forEachCut(level, [&](uint32_t i) {
+            const uint32_t *v = corners(i);
+            clip::Wet wet = clip::cut(mesh.x[v[0]], mesh.y[v[0]], mesh.z[v[0]], mesh.x[v[1]], mesh.y[v[1]],
+                                      mesh.z[v[1]], mesh.x[v[2]], mesh.y[v[2]], mesh.z[v[2]], level);
+            sum.volume += wet.volume;
+            sum.area += wet.area;
+        });
+        return {orientation * sum.volume, orientation * sum.area};
+    }
+
+    // Volume, centre of mass, wetted wall and free surface from a single pass over the faces.
+    LiquidState getLiquidByLevel(double level) const {
+        if (storage) {
+            mesh.checkIndex();
+        }
+        return liquidState(clip::liquidRange(mesh, 0, mesh.triangles(), level));
+    }
+
+    LiquidState getLiquidByLevel(double level, VolumeScanner &scanner) const {
+        return liquidState(scanner.liquid(mesh, level));
+    }
+
+    // Newton on V(h) with A(h) = dV/dh, without the precomputed curve.
+    LevelSolution solveLevelByVolume(double volume, const LevelSolverOptions &options = {}) const {
+        return solveLevel(volume, lowestPoint, highestPoint, std::fabs(index.submerged(highestPoint)),
+                          [&](double level) { return getWetByLevel(level); }, options);
+    }
+
+    // The same with full scans, for meshes without an index.
+    LevelSolution solveLevelByVolume(double volume, VolumeScanner &scanner,
+                                     const LevelSolverOptions &options = {}) const {
+        clip::Wet top = scanner.wet(mesh, highestPoint);
+        double sign = top.volume < 0 ? -1 : 1;
+        LevelSolution solution = solveLevel(volume, lowestPoint, highestPoint, sign * top.volume, [&](double level) {
+            clip::Wet wet = scanner.wet(mesh, level);
+            return clip::Wet{sign * wet.volume, sign * wet.area};
+        }, options);
+        solution.meshPasses++;
+        return solution;
+    }
+
+    double getLevelByVolume(double volume, bool needSplit) {
+        if (needSplit) {
+            return curve.level(volume);
+        }
+        double lower = lowestPoint;
+        double higher = highestPoint;
+        while (higher - lower > 1e-6) {
+            double mid = (lower + higher) / 2;
+            if (getVolumeByLevelNoSplit(mid) > volume) {
+                higher = mid;
+            } else {
+                lower = mid;
+            }
+        }
+        return lower;
+    }
+
+    // Whole strapping tables at once: one sorted walk over the exact volume curve
+    // instead of a separate search per row.
+    std::vector<double> getLevelsByVolumes(const std::vector<double> &volumes) const {
+        return curve.levels(volumes);
+    }
+
+    std::vector<double> getVolumesByLevels(const std::vector<double> &levels) const {
+        return curve.volumesAt(levels);
+    }
+
+private:
+    // Corners of face i; a mapped index is not checked up front, so they are checked here.
+    const uint32_t *corners(uint32_t i) const {
+        const uint32_t *v = &mesh.index[i * 3];
+        size_t n = mesh.vertices();
+        if (v[0] >= n || v[1] >= n || v[2] >= n) {
+            throw std::runtime_error("tank: vertex index out of range");
+        }
+        return v;
+    }
+
+    LiquidState liquidState(const clip::Liquid &sum) const {
+        double volume = orientation * sum.volume;
+        Point centroid;
+        if (volume != 0) {
+            centroid = {sum.moment[0] / sum.volume, sum.moment[1] / sum.volume, sum.moment[2] / sum.volume};
+        }
+        return {volume, centroid, sum.wettedArea, orientation * sum.surfaceArea};
+    }
+
+    // The compiled tank the arrays point into, if loaded from one; shared by copies of the tank.
+    std::shared_ptr<const MappedFile> storage;
+};
+
+#endif //HW3_TANK_H
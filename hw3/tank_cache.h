@@ -0,0 +1,291 @@
+#ifndef HW3_TANK_CACHE_H
+#define HW3_TANK_CACHE_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include "array.h"
+#include "mapped_file.h"
+
+// Скомпилированный бак: все массивы модели (сетка, кривая V(h), индекс по высоте) одним
+// двоичным файлом. Файл отображается в память, и массивы смотрят прямо в него, без разбора
+// и копирования: старт читает только заголовок и таблицу разделов, а страницы данных подгружаются,
+// когда их касаются запросы.
+//
+// Формат: заголовок, таблица разделов, затем разделы, каждый с границы 64 байт. Раздел 0 --
+// скалярные поля модели, остальные -- массивы в порядке, в котором их перечисляет fields().
+// Файл привязан к исходному STL по размеру, времени изменения и контрольной сумме. Его собственное
+// содержимое закрыто своей суммой, но она проверяется один раз после записи и при открытии только
+// по просьбе: обычное открытие сверяет заголовок, раскладку разделов и согласованность размеров
+// массивов модели, а хранимые номера вершин и треугольников проверяются на диапазон там, где их читают.
+
+namespace tank_cache {
+
+    const char MAGIC[8] = {'T', 'A', 'N', 'K', 'B', 'I', 'N', '\0'};
+    // Bump whenever a model's fields(), an element layout or the way a stored table is built changes.
+    // 2: the volume curve is built in double-double. 3: the contents checksum.
+    const uint32_t VERSION = 3;
+    const uint32_t ENDIAN_MARK = 0x01020304;
+    const uint64_t ALIGNMENT = 64;
+
+    struct Source {
+        uint64_t size;
+        int64_t mtime;  // nanoseconds
+        uint64_t checksum;
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t endianMark;
+        uint32_t sections;
+        uint32_t reserved;
+        Source source;
+        uint64_t contents;  // checksum of the section table and every section
+    };
+
+    struct Section {
+        uint64_t offset;
+        uint64_t count;
+        uint64_t elementSize;
+    };
+
+    inline uint64_t checksum(const char *data, size_t size) {
+        uint64_t h = 0x9e3779b97f4a7c15ULL ^ size;
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            uint64_t word;
+            std::memcpy(&word, data + i, 8);
+            h = (h ^ word) * 0xff51afd7ed558ccdULL;
+            h ^= h >> 32;
+        }
+        uint64_t tail = 0;
+        if (i < size) {
+            std::memcpy(&tail, data + i, size - i);
+        }
+        h = (h ^ tail) * 0xc4ceb9fe1a85ec53ULL;
+        return h ^ (h >> 29);
+    }
+
+    // Size and modification time only; the checksum is filled in when it is actually needed.
+    inline Source describe(const std::string &path) {
+        struct stat info = {};
+        if (stat(path.c_str(), &info) != 0) {
+            throw std::runtime_error(path + ": " + std::strerror(errno));
+        }
+        return {(uint64_t) info.st_size, (int64_t) info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec, 0};
+    }
+
+    inline uint64_t checksumOf(const std::string &path) {
+        MappedFile file(path);
+        return checksum(file.data(), file.size());
+    }
+
+    // Chains the checksums of the section table and of every section in order.
+    inline uint64_t contentsChecksum(const Section *sections, size_t count, const char *const *data) {
+        uint64_t h = checksum(reinterpret_cast<const char *>(sections), count * sizeof(Section));
+        for (size_t i = 0; i < count; i++) {
+            h = (h ^ checksum(data[i], sections[i].count * sections[i].elementSize)) * 0x9e3779b97f4a7c15ULL;
+        }
+        return h;
+    }
+
+    inline uint64_t aligned(uint64_t offset) {
+        return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    // Collects the fields of a model in fields() order.
+    struct Writer {
+        std::vector<double> scalars;
+        std::vector<const char *> data;
+        std::vector<Section> sections;
+
+        void operator()(double &value) {
+            scalars.push_back(value);
+        }
+
+        template<class T>
+        void operator()(Array<T> &array) {
+            data.push_back(reinterpret_cast<const char *>(array.data()));
+            sections.push_back({0, array.size(), sizeof(T)});
+        }
+    };
+
+    // Points the fields of a model into a mapped file, or only checks that they fit with bind = false.
+    struct Reader {
+        const char *base;
+        const Section *sections;
+        size_t count;
+        bool bind;
+        size_t next = 1;
+        size_t scalar = 0;
+        bool ok = true;
+
+        void operator()(double &value) {
+            const Section &section = sections[0];
+            if (scalar >= section.count) {
+                ok = false;
+            } else if (bind) {
+                std::memcpy(&value, base + section.offset + scalar * sizeof(double), sizeof(double));
+            }
+            scalar++;
+        }
+
+        template<class T>
+        void operator()(Array<T> &array) {
+            if (next >= count || sections[next].elementSize != sizeof(T)) {
+                ok = false;
+            } else if (bind) {
+                array = Array<T>::view(reinterpret_cast<const T *>(base + sections[next].offset), sections[next].count);
+            }
+            next++;
+        }
+    };
+
+    // The contents checksum of a mapped file whose header and section table are already checked.
+    inline bool intact(const char *base, const Header &header) {
+        const auto *sections = reinterpret_cast<const Section *>(base + sizeof(Header));
+        std::vector<const char *> data(header.sections);
+        for (uint32_t i = 0; i < header.sections; i++) {
+            data[i] = base + sections[i].offset;
+        }
+        return contentsChecksum(sections, header.sections, data.data()) == header.contents;
+    }
+
+    // Writes the model next to its source atomically: a reader sees either the old file or the new one.
+    // The written file is read back once and checked against the contents checksum, so a bad write
+    // is caught here rather than on every later open.
+    template<class Model>
+    void save(const std::string &path, const std::string &stlPath, Model &model) {
+        Header header = {};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.endianMark = ENDIAN_MARK;
+        header.source = describe(stlPath);
+        header.source.checksum = checksumOf(stlPath);
+
+        Writer writer;
+        model.fields(writer);
+        writer.data.insert(writer.data.begin(), reinterpret_cast<const char *>(writer.scalars.data()));
+        writer.sections.insert(writer.sections.begin(), {0, writer.scalars.size(), sizeof(double)});
+        header.sections = (uint32_t) writer.sections.size();
+        uint64_t offset = sizeof(Header) + writer.sections.size() * sizeof(Section);
+        for (auto &section: writer.sections) {
+            section.offset = aligned(offset);
+            offset = section.offset + section.count * section.elementSize;
+        }
+        header.contents = contentsChecksum(writer.sections.data(), writer.sections.size(), writer.data.data());
+
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char *>(writer.sections.data()),
+                      (std::streamsize) (writer.sections.size() * sizeof(Section)));
+            uint64_t position = sizeof(Header) + writer.sections.size() * sizeof(Section);
+            static const char zeros[ALIGNMENT] = {};
+            for (size_t i = 0; i < writer.sections.size(); i++) {
+                const Section &section = writer.sections[i];
+                out.write(zeros, (std::streamsize) (section.offset - position));
+                out.write(writer.data[i], (std::streamsize) (section.count * section.elementSize));
+                position = section.offset + section.count * section.elementSize;
+            }
+            if (!out.flush()) {
+                out.close();
+                std::remove(temporary.c_str());
+                throw std::runtime_error(temporary + ": write failed");
+            }
+        }
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+            int error = errno;
+            std::remove(temporary.c_str());
+            throw std::runtime_error(path + ": " + std::strerror(error));
+        }
+        bool written;
+        {
+            MappedFile file(path);
+            written = file.size() == offset && intact(file.data(), header);
+        }
+        if (!written) {
+            std::remove(path.c_str());
+            throw std::runtime_error(path + ": written file does not match its checksum");
+        }
+    }
+
+    // Maps a compiled tank and points the model's fields into it. Returns nullptr, leaving the model
+    // untouched, when the file is missing, foreign, damaged (its layout or the sizes of its arrays
+    // do not fit, per model.consistent()) or was built from a different STL. With verify the contents
+    // checksum is compared too, which reads the whole file.
+    // The model's arrays are valid while the returned mapping is alive.
+    //
+    // A matching size and modification time of the STL are trusted; otherwise the STL is read once
+    // to compare checksums, so a copied or touched but unchanged file keeps its cache.
+    template<class Model>
+    std::shared_ptr<const MappedFile> open(const std::string &path, const std::string &stlPath, Model &model,
+                                           bool verify = false) {
+        std::shared_ptr<const MappedFile> file;
+        try {
+            file = std::make_shared<const MappedFile>(path, MADV_NORMAL);
+        } catch (const std::runtime_error &) {
+            return nullptr;
+        }
+        const char *base = file->data();
+        size_t size = file->size();
+        Header header;
+        if (size < sizeof(Header)) {
+            return nullptr;
+        }
+        std::memcpy(&header, base, sizeof(Header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+            header.endianMark != ENDIAN_MARK || header.sections == 0 ||
+            header.sections > (size - sizeof(Header)) / sizeof(Section)) {
+            return nullptr;
+        }
+
+        Source source = describe(stlPath);
+        if (source.size != header.source.size ||
+            (source.mtime != header.source.mtime && checksumOf(stlPath) != header.source.checksum)) {
+            return nullptr;
+        }
+
+        // The header is 64-byte aligned in the mapping, so the section table is 8-byte aligned.
+        const auto *sections = reinterpret_cast<const Section *>(base + sizeof(Header));
+        for (uint32_t i = 0; i < header.sections; i++) {
+            const Section &section = sections[i];
+            if (section.offset % ALIGNMENT != 0 || section.offset > size || section.elementSize == 0 ||
+                section.count > (size - section.offset) / section.elementSize) {
+                return nullptr;
+            }
+        }
+        if (sections[0].elementSize != sizeof(double)) {
+            return nullptr;
+        }
+        if (verify && !intact(base, header)) {
+            return nullptr;
+        }
+
+        Reader check = {base, sections, header.sections, false};
+        model.fields(check);
+        if (!check.ok || check.next != header.sections || check.scalar != sections[0].count) {
+            return nullptr;
+        }
+        Model bound;
+        Reader reader = {base, sections, header.sections, true};
+        bound.fields(reader);
+        if (!bound.consistent()) {
+            return nullptr;
+        }
+        model = std::move(bound);
+        return file;
+    }
+
+}
+
+#endif //HW3_TANK_CACHE_H
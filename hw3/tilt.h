@@ -0,0 +1,176 @@
+#ifndef HW3_TILT_H
+#define HW3_TILT_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+#include "mesh.h"
+#include "volume_curve.h"
+#include "clip.h"
+
+// Объём и уровень при наклонённом баке: зеркало -- плоскость n . x = level с произвольной
+// единичной нормалью n, жидкость там, где n . x <= level.
+//
+// Сетка пересчитывается в ортонормированный базис (u, v, n) с началом в центре габаритов, и дальше
+// работают те же срезание и кривая V(h), что и для горизонтального зеркала. При малом изменении
+// наклона порядок вершин вдоль нормали почти не меняется, поэтому он хранится между вызовами
+// и досортировывается вставками, а не сортируется заново.
+//
+// Новый наклон только пересчитывает координаты на месте; досортировка и кривая строятся при первом
+// запросе уровня или объёма, так что наклоны, между которыми ничего не спрашивали, почти бесплатны,
+// и всё это -- в памяти, оставшейся от прошлого построения. Вид держит свою копию сетки и от бака
+// после построения не зависит.
+class TiltedView {
+public:
+    // Insertion sort gives up after this many moves per vertex and falls back to a full sort.
+    static constexpr double MAX_MOVES_PER_VERTEX = 8;
+
+    explicit TiltedView(const Mesh &mesh) {
+        mesh.checkIndex();
+        size_t vertices = mesh.vertices();
+        if (vertices > 0) {
+            auto xs = std::minmax_element(mesh.x.begin(), mesh.x.end());
+            auto ys = std::minmax_element(mesh.y.begin(), mesh.y.end());
+            auto zs = std::minmax_element(mesh.z.begin(), mesh.z.end());
+            center[0] = (*xs.first + *xs.second) / 2;
+            center[1] = (*ys.first + *ys.second) / 2;
+            center[2] = (*zs.first + *zs.second) / 2;
+        }
+        for (int k = 0; k < 3; k++) {
+            base[k].resize(vertices);
+            projected[k].resize(vertices);
+        }
+        for (size_t i = 0; i < vertices; i++) {
+            base[0][i] = mesh.x[i] - center[0];
+            base[1][i] = mesh.y[i] - center[1];
+            base[2][i] = mesh.z[i] - center[2];
+        }
+        frame.x = Array<double>::view(projected[0].data(), vertices);
+        frame.y = Array<double>::view(projected[1].data(), vertices);
+        frame.z = Array<double>::view(projected[2].data(), vertices);
+        frame.index = std::vector<uint32_t>(mesh.index.begin(), mesh.index.end());
+        order.resize(vertices);
+        std::iota(order.begin(), order.end(), 0);
+        setNormal(0, 0, 1);
+    }
+
+    // frame views the buffers of this very object.
+    TiltedView(const TiltedView &) = delete;
+
+    TiltedView &operator=(const TiltedView &) = delete;
+
+    // Upward vertical in the tank's own axes for a tank pitched by pitch about y, then rolled by roll
+    // about x (radians).
+    void setAttitude(double pitch, double roll) {
+        setNormal(-std::sin(pitch), std::sin(roll) * std::cos(pitch), std::cos(roll) * std::cos(pitch));
+    }
+
+    void setNormal(double nx, double ny, double nz) {
+        double length = std::sqrt(nx * nx + ny * ny + nz * nz);
+        if (!(length > 0)) {
+            throw std::invalid_argument("tilt: zero normal");
+        }
+        n[0] = nx / length;
+        n[1] = ny / length;
+        n[2] = nz / length;
+        // Right-handed completion of n (Duff et al., 2017): u x v = n, so volumes keep their sign.
+        double sign = std::copysign(1.0, n[2]);
+        double a = -1.0 / (sign + n[2]);
+        double b = n[0] * n[1] * a;
+        double u[3] = {1.0 + sign * n[0] * n[0] * a, sign * b, -sign * n[0]};
+        double v[3] = {b, sign + n[1] * n[1] * a, -n[1]};
+        const double *px = base[0].data(), *py = base[1].data(), *pz = base[2].data();
+        double *xs = projected[0].data(), *ys = projected[1].data(), *zs = projected[2].data();
+        for (size_t i = 0; i < order.size(); i++) {
+            xs[i] = u[0] * px[i] + u[1] * py[i] + u[2] * pz[i];
+            ys[i] = v[0] * px[i] + v[1] * py[i] + v[2] * pz[i];
+            zs[i] = n[0] * px[i] + n[1] * py[i] + n[2] * pz[i];
+        }
+        offset = n[0] * center[0] + n[1] * center[1] + n[2] * center[2];
+        stale = true;
+    }
+
+    // Level is the plane offset along the normal in tank coordinates: the plane is n . x = level.
+    double volume(double level) {
+        return current().volume(level - offset);
+    }
+
+    double level(double volume) {
+        return current().level(volume) + offset;
+    }
+
+    std::vector<double> levels(const std::vector<double> &volumes) {
+        std::vector<double> result = current().levels(volumes);
+        for (auto &value: result) {
+            value += offset;
+        }
+        return result;
+    }
+
+    double lowest() {
+        return current().lowest() + offset;
+    }
+
+    double highest() {
+        return current().highest() + offset;
+    }
+
+    // A single volume from a full scan of the rotated mesh, without relying on the curve.
+    double scanVolume(double level, VolumeScanner &scanner) const {
+        return std::fabs(scanner.volume(frame, level - offset));
+    }
+
+    // Insertion moves made by the last re-sort, or -1 when it fell back to a full sort. The re-sort runs
+    // with the first query after a change of the normal.
+    long long lastMoves() const noexcept {
+        return moves;
+    }
+
+private:
+    double center[3] = {0, 0, 0};
+    std::vector<double> base[3];       // vertices relative to center, in the tank's axes
+    std::vector<double> projected[3];  // the same in (u, v, n), viewed by frame
+    Mesh frame;
+    double n[3] = {0, 0, 1};
+    double offset = 0;
+    std::vector<uint32_t> order;
+    VolumeCurve curve;
+    VolumeCurve::Scratch scratch;
+    bool stale = true;
+    long long moves = 0;
+
+    const VolumeCurve &current() {
+        if (stale) {
+            resort();
+            curve.rebuild(frame, order, scratch);
+            stale = false;
+        }
+        return curve;
+    }
+
+    void resort() {
+        const Array<double> &z = frame.z;
+        long long budget = (long long) (MAX_MOVES_PER_VERTEX * (double) order.size());
+        moves = 0;
+        for (size_t i = 1; i < order.size(); i++) {
+            uint32_t vertex = order[i];
+            double key = z[vertex];
+            size_t j = i;
+            for (; j > 0 && z[order[j - 1]] > key; j--) {
+                order[j] = order[j - 1];
+            }
+            order[j] = vertex;
+            moves += (long long) (i - j);
+            if (moves > budget) {
+                std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return z[a] < z[b]; });
+                moves = -1;
+                return;
+            }
+        }
+    }
+};
+
+#endif //HW3_TILT_H
@@ -0,0 +1,368 @@
+#ifndef HW3_VOLUME_CURVE_H
+#define HW3_VOLUME_CURVE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+#include "array.h"
+#include "mesh.h"
+
+// Объём жидкости как функция уровня, V(h), построенный заранее и точно.
+//
+// Площадь сечения A(h) по формуле Грина -- сумма по треугольникам, которые пересекает
+// плоскость z = h, от (q x p)_z / 2, где p и q -- точки пересечения с рёбрами. Между соседними
+// высотами вершин p и q линейны по h, так что A -- квадратичный многочлен, а V = integral A dh --
+// кубический. Таблица хранит по интервалу коэффициенты A и V на его левом конце; запрос --
+// бинарный поиск и вычисление (или решение) кубического многочлена.
+//
+// Коэффициенты копятся по всем интервалам сразу и сокращаются между почти горизонтальными
+// рёбрами, поэтому при построении они ведутся в двойной-двойной точности (Wide) и только
+// коэффициенты каждого интервала в его собственной переменной округляются до double.
+class VolumeCurve {
+public:
+    static VolumeCurve build(const Mesh &mesh) {
+        std::vector<uint32_t> order(mesh.vertices());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return mesh.z[a] < mesh.z[b]; });
+        return build(mesh, order);
+    }
+
+    // order -- all vertices by ascending z, e.g. kept from a previous build and re-sorted.
+    static VolumeCurve build(const Mesh &mesh, const std::vector<uint32_t> &order) {
+        VolumeCurve curve;
+        Scratch scratch;
+        curve.rebuild(mesh, order, scratch);
+        return curve;
+    }
+
+    // Working memory of a build, kept by callers that rebuild the curve again and again.
+    struct Scratch;
+
+    // Builds the curve anew in the memory of the current one and of scratch, so a caller that rebuilds
+    // on every change of the mesh, like TiltedView, allocates only when the mesh grows.
+    void rebuild(const Mesh &mesh, const std::vector<uint32_t> &order, Scratch &scratch) {
+        std::vector<double> heights = breaks.release(), cumulative = volumes.release(), coefficients = area.release();
+        heights.clear();
+        size_t vertices = mesh.vertices();
+        if (vertices == 0) {
+            return;
+        }
+        // x and y are shifted to the bounding box centre, so the Green terms do not cancel for meshes
+        // far from the origin; heights stay as they are and are only ever subtracted exactly, in Wide.
+        auto xs = std::minmax_element(mesh.x.begin(), mesh.x.end());
+        auto ys = std::minmax_element(mesh.y.begin(), mesh.y.end());
+        double cx = (*xs.first + *xs.second) / 2;
+        double cy = (*ys.first + *ys.second) / 2;
+
+        std::vector<uint32_t> &rank = scratch.rank;
+        rank.resize(vertices);
+        for (uint32_t v: order) {
+            if (heights.empty() || heights.back() != mesh.z[v]) {
+                heights.push_back(mesh.z[v]);
+            }
+            rank[v] = (uint32_t) heights.size() - 1;
+        }
+
+        // Difference array of A's coefficients in h itself: a triangle adds its quadratic where its part
+        // starts and subtracts it where the part ends. A nearly horizontal edge makes these terms huge while
+        // the area they describe stays small, so they are added and cancelled in double-double: in plain
+        // doubles the rounding of every such pair stays in the running sum for all the intervals above it.
+        size_t intervals = heights.size();
+        std::vector<Wide> &delta = scratch.delta;
+        delta.assign(intervals * 3, Wide());
+        auto addPart = [&](const uint32_t *v, int lone, bool loneBelow) {
+            uint32_t l = v[lone], e1 = v[(lone + 1) % 3], e2 = v[(lone + 2) % 3];
+            uint32_t from = loneBelow ? rank[l] : std::max(rank[e1], rank[e2]);
+            uint32_t to = loneBelow ? std::min(rank[e1], rank[e2]) : rank[l];
+            if (from == to) {
+                return;
+            }
+            double lx = mesh.x[l] - cx, ly = mesh.y[l] - cy;
+            // p = l + p1 w on the edge l-e1, q = l + q1 w on the edge l-e2, w = h - z_l.
+            double p1x = (mesh.x[e1] - mesh.x[l]) / (mesh.z[e1] - mesh.z[l]);
+            double p1y = (mesh.y[e1] - mesh.y[l]) / (mesh.z[e1] - mesh.z[l]);
+            double q1x = (mesh.x[e2] - mesh.x[l]) / (mesh.z[e2] - mesh.z[l]);
+            double q1y = (mesh.y[e2] - mesh.y[l]) / (mesh.z[e2] - mesh.z[l]);
+            // The free surface is traversed q -> p when the lone vertex is wet, p -> q otherwise;
+            // (q x p)_z = w (l x p1 + q1 x l)_z + w^2 (q1 x p1)_z.
+            double sign = loneBelow ? 0.5 : -0.5;
+            Wide c[3] = {
+                    Wide(0),
+                    Wide(sign * ((lx * p1y - ly * p1x) + (q1x * ly - q1y * lx))),
+                    Wide(sign * (q1x * p1y - q1y * p1x))
+            };
+            shift(c, -mesh.z[l]);
+            for (int k = 0; k < 3; k++) {
+                delta[from * 3 + k] = delta[from * 3 + k] + c[k];
+                delta[to * 3 + k] = delta[to * 3 + k] - c[k];
+            }
+        };
+        for (size_t i = 0; i < mesh.triangles(); i++) {
+            const uint32_t *v = &mesh.index[i * 3];
+            int low = 0, high = 0;
+            for (int k = 1; k < 3; k++) {
+                low = mesh.z[v[k]] < mesh.z[v[low]] ? k : low;
+                high = mesh.z[v[k]] >= mesh.z[v[high]] ? k : high;
+            }
+            if (low == high) {
+                continue;
+            }
+            // Below the middle vertex the lowest one is alone under the plane, above it the highest one is alone.
+            addPart(v, low, true);
+            addPart(v, high, false);
+        }
+
+        coefficients.resize((intervals - 1) * 3);
+        cumulative.assign(intervals, 0.0);
+        Wide a[3], total;
+        for (size_t k = 0; k + 1 < intervals; k++) {
+            for (int j = 0; j < 3; j++) {
+                a[j] = a[j] + delta[k * 3 + j];
+            }
+            // To the local variable u = h - breaks[k].
+            Wide local[3] = {a[0], a[1], a[2]};
+            shift(local, heights[k]);
+            double *stored = &coefficients[k * 3];
+            for (int j = 0; j < 3; j++) {
+                stored[j] = local[j].value();
+            }
+            total = total + Wide(integral(stored, heights[k + 1] - heights[k]));
+            cumulative[k + 1] = total.value();
+        }
+        // An inward-facing mesh gives negative areas throughout.
+        if (cumulative.back() < 0) {
+            for (auto &value: coefficients) {
+                value = -value;
+            }
+            for (auto &value: cumulative) {
+                value = -value;
+            }
+        }
+        breaks = std::move(heights);
+        volumes = std::move(cumulative);
+        area = std::move(coefficients);
+    }
+
+    // Calls f on every array in a fixed order, for saving and loading a compiled tank.
+    template<class F>
+    void fields(F &&f) {
+        f(breaks);
+        f(volumes);
+        f(area);
+    }
+
+    bool empty() const noexcept {
+        return breaks.size() < 2;
+    }
+
+    // The arrays agree in size, e.g. after mapping a compiled tank.
+    bool consistent() const noexcept {
+        return volumes.size() == breaks.size() && area.size() == (breaks.empty() ? 0 : (breaks.size() - 1) * 3);
+    }
+
+    double lowest() const {
+        return breaks.front();
+    }
+
+    double highest() const {
+        return breaks.back();
+    }
+
+    double totalVolume() const {
+        return volumes.back();
+    }
+
+    double volume(double level) const {
+        if (empty() || level <= breaks.front()) {
+            return 0;
+        }
+        if (level >= breaks.back()) {
+            return volumes.back();
+        }
+        size_t k = std::upper_bound(breaks.begin(), breaks.end(), level) - breaks.begin() - 1;
+        return volumes[k] + integral(&area[k * 3], level - breaks[k]);
+    }
+
+    // Cross-section area at the level, dV/dh.
+    double crossSection(double level) const {
+        if (empty() || level < breaks.front() || level >= breaks.back()) {
+            return 0;
+        }
+        size_t k = std::upper_bound(breaks.begin(), breaks.end(), level) - breaks.begin() - 1;
+        const double *a = &area[k * 3];
+        double u = level - breaks[k];
+        return a[0] + u * (a[1] + u * a[2]);
+    }
+
+    double level(double volume) const {
+        if (empty() || volume <= 0) {
+            return empty() ? 0 : breaks.front();
+        }
+        if (volume >= volumes.back()) {
+            return breaks.back();
+        }
+        size_t k = std::upper_bound(volumes.begin(), volumes.end(), volume) - volumes.begin() - 1;
+        k = std::min(k, breaks.size() - 2);
+        return breaks[k] + solve(&area[k * 3], volume - volumes[k], breaks[k + 1] - breaks[k]);
+    }
+
+    // Batch versions: the queries are sorted and resolved in one walk over the intervals,
+    // results come back in the order of the queries.
+    std::vector<double> levels(const std::vector<double> &queries) const {
+        std::vector<double> result(queries.size());
+        size_t k = 0;
+        for (size_t i: sortedOrder(queries)) {
+            double volume = queries[i];
+            if (empty() || volume <= 0) {
+                result[i] = empty() ? 0 : breaks.front();
+                continue;
+            }
+            if (volume >= volumes.back()) {
+                result[i] = breaks.back();
+                continue;
+            }
+            while (k + 2 < breaks.size() && volumes[k + 1] <= volume) {
+                k++;
+            }
+            result[i] = breaks[k] + solve(&area[k * 3], volume - volumes[k], breaks[k + 1] - breaks[k]);
+        }
+        return result;
+    }
+
+    std::vector<double> volumesAt(const std::vector<double> &queries) const {
+        std::vector<double> result(queries.size());
+        size_t k = 0;
+        for (size_t i: sortedOrder(queries)) {
+            double level = queries[i];
+            if (empty() || level <= breaks.front()) {
+                result[i] = 0;
+                continue;
+            }
+            if (level >= breaks.back()) {
+                result[i] = volumes.back();
+                continue;
+            }
+            while (breaks[k + 1] <= level) {
+                k++;
+            }
+            result[i] = volumes[k] + integral(&area[k * 3], level - breaks[k]);
+        }
+        return result;
+    }
+
+private:
+    Array<double> breaks;   // distinct vertex heights, ascending
+    Array<double> volumes;  // V at every break
+    Array<double> area;     // per interval: A(u) = area[0] + area[1] u + area[2] u^2
+
+    // Double-double: an unevaluated sum hi + lo with about 106 bits, enough for the building sums.
+    struct Wide {
+        double hi = 0, lo = 0;
+
+        Wide() = default;
+
+        explicit Wide(double value) : hi(value) {
+        }
+
+        Wide(double hi, double lo) : hi(hi), lo(lo) {
+        }
+
+        double value() const {
+            return hi + lo;
+        }
+
+        // Knuth's two-sum: s + e == a + b exactly.
+        static Wide twoSum(double a, double b) {
+            double s = a + b;
+            double v = s - a;
+            return {s, (a - (s - v)) + (b - v)};
+        }
+
+        // Dekker's product: p + e == a * b exactly, without relying on FMA.
+        static Wide twoProduct(double a, double b) {
+            const double split = 134217729.0;  // 2^27 + 1
+            double p = a * b;
+            double ta = split * a, tb = split * b;
+            double ah = ta - (ta - a), bh = tb - (tb - b);
+            double al = a - ah, bl = b - bh;
+            return {p, ((ah * bh - p) + ah * bl + al * bh) + al * bl};
+        }
+
+        static Wide normalize(double hi, double lo) {
+            double s = hi + lo;
+            return {s, lo - (s - hi)};
+        }
+
+        friend Wide operator+(const Wide &a, const Wide &b) {
+            Wide s = twoSum(a.hi, b.hi), t = twoSum(a.lo, b.lo);
+            s = normalize(s.hi, s.lo + t.hi);
+            return normalize(s.hi, s.lo + t.lo);
+        }
+
+        friend Wide operator-(const Wide &a, const Wide &b) {
+            return a + Wide(-b.hi, -b.lo);
+        }
+
+        friend Wide operator*(const Wide &a, double b) {
+            Wide p = twoProduct(a.hi, b);
+            return normalize(p.hi, p.lo + a.lo * b);
+        }
+    };
+
+public:
+    struct Scratch {
+        std::vector<uint32_t> rank;
+        std::vector<Wide> delta;
+    };
+
+private:
+    // c(x) -> c(y + s): the quadratic c0 + c1 x + c2 x^2 in the variable y = x - s.
+    static void shift(Wide *c, double s) {
+        c[0] = c[0] + (c[1] + c[2] * s) * s;
+        c[1] = c[1] + c[2] * (2 * s);
+    }
+
+    // Calibration tables usually come sorted already, then this is a single check.
+    static std::vector<size_t> sortedOrder(const std::vector<double> &queries) {
+        std::vector<size_t> order(queries.size());
+        std::iota(order.begin(), order.end(), 0);
+        if (!std::is_sorted(queries.begin(), queries.end())) {
+            std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return queries[a] < queries[b]; });
+        }
+        return order;
+    }
+
+    static double integral(const double *a, double u) {
+        return u * (a[0] + u * (a[1] / 2 + u * a[2] / 3));
+    }
+
+    // The root of integral(a, u) = target on [0, width]. The integral is monotone, so Newton steps
+    // are kept inside a shrinking bracket and fall back to bisection when they leave it.
+    static double solve(const double *a, double target, double width) {
+        double lo = 0, hi = width;
+        double u = width / 2;
+        for (int step = 0; step < 100; step++) {
+            double f = integral(a, u) - target;
+            if (f > 0) {
+                hi = u;
+            } else {
+                lo = u;
+            }
+            double slope = a[0] + u * (a[1] + u * a[2]);
+            double next = slope > 0 ? u - f / slope : (lo + hi) / 2;
+            if (!(next > lo && next < hi)) {
+                next = (lo + hi) / 2;
+            }
+            if (std::fabs(next - u) <= 4 * std::numeric_limits<double>::epsilon() * width) {
+                return next;
+            }
+            u = next;
+        }
+        return u;
+    }
+};
+
+#endif //HW3_VOLUME_CURVE_H